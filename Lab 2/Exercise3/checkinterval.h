@@ -0,0 +1,108 @@
+/*************************************************************************
+** Interval of the convergence check for the Jacobi method
+**
+** Computing the maximum change of the elements costs an additional load,
+** subtraction and comparison per element, and with MPI a global reduction
+** per iteration. So it is only done every few iterations.
+**
+** The maximum change decreases monotonically (the iteration matrix of
+** Jacobi is nonnegative with row sums <= 1) and, after a few iterations,
+** approximately geometrically. From the changes at the last checks, the
+** number of iterations until 'eps' is reached is estimated, and the
+** next check is done after at most half of these iterations. So close to
+** the end, the change is checked in every iteration again, and the number
+** of iterations is the same as with a check in each iteration.
+**
+** The convergence factor is estimated over at least two iterations: the
+** eigenvalues of the Jacobi iteration matrix come in pairs +-lambda, so
+** the change often decreases in steps, i.e., it stays almost the same
+** for two iterations.
+**
+** If the estimate was wrong, i.e., the accuracy is reached at a check
+** after more than one unchecked iteration, this is reported, since up to
+** (interval - 1) more iterations than necessary may have been executed.
+**
+** Environment variable:
+**   CHECK_INTERVAL  maximum interval (default 16). CHECK_INTERVAL=1 checks
+**                   in every iteration.
+**
+** Author:   RW
+**
+*************************************************************************/
+
+#include <iostream>
+#include <stdlib.h>
+#include <math.h>
+
+class CheckInterval
+{
+public:
+	CheckInterval()
+	{
+		const char *env = getenv("CHECK_INTERVAL");
+		kmax = (env != NULL) ? atoi(env) : 16;
+		if (kmax < 1)
+			kmax = 1;
+		lastK = prevK = 0;
+		lastDiff = prevDiff = 0;
+		interval = 1;
+		nextK = 1;
+	}
+
+	/*
+	** True, if the change must be computed in iteration 'k' (counting
+	** from 1).
+	*/
+	bool check(int k) const
+	{
+		return k >= nextK;
+	}
+
+	/*
+	** Must be called after each checked iteration 'k' with the (global)
+	** maximum change 'diff'. Returns true, if the accuracy 'eps' has been
+	** reached.
+	*/
+	bool done(int k, double diff, double eps)
+	{
+		if (diff <= eps) {
+			if (interval > 1) {
+				std::cerr << "CheckInterval: converged at a check after "
+						  << interval << " iterations, up to "
+						  << interval - 1 << " more than necessary\n";
+			}
+			return true;
+		}
+
+		/*
+		** Estimate the convergence factor per iteration and the number of
+		** remaining iterations.
+		*/
+		int refK = (k - lastK >= 2) ? lastK : prevK;
+		double refDiff = (k - lastK >= 2) ? lastDiff : prevDiff;
+		interval = 1;
+		if ((refDiff > 0) && (diff < refDiff)) {
+			double r = pow(diff / refDiff, 1.0 / (k - refK));
+			double rest = log(eps / diff) / log(r);
+			if (rest > 2 * kmax)
+				interval = kmax;
+			else if (rest >= 2)
+				interval = (int)(rest / 2);
+		}
+		prevK = lastK;
+		prevDiff = lastDiff;
+		lastK = k;
+		lastDiff = diff;
+		nextK = k + interval;
+		return false;
+	}
+
+private:
+	int kmax;         /* Maximum interval */
+	int lastK;        /* Iteration of the last check */
+	double lastDiff;  /* Maximum change at the last check */
+	int prevK;        /* The same for the check before */
+	double prevDiff;
+	int interval;     /* Iterations since the last check */
+	int nextK;        /* Iteration of the next check */
+};
@@ -0,0 +1,148 @@
+/*************************************************************************
+** File formats for the matrix
+**
+** Binary (Matrix.bin): a header of 32 bytes, followed by the elements
+** of the matrix, row by row (a[0][0], a[0][1], ...), as raw IEEE 754
+** doubles without any padding. So element a[i][j] is at byte offset
+**   sizeof(MatrixFileHeader) + (i*cols + j) * 8
+** and the file can be read with one read() or mapped with mmap().
+** The header and the elements are written in the byte order of the
+** writing machine. A reader can detect a different byte order with the
+** 'endian' field.
+**
+** Text (Matrix.txt, for ViewMatrix): the size, an empty line, and then
+** the elements with 10 significant digits, one per line, with an empty
+** line after each row. The numbers are formatted with std::to_chars,
+** which gives exactly the same text as 'file << setprecision(10) << x',
+** but without the overhead of the streams.
+**
+** Author:   RW
+**
+*************************************************************************/
+
+#ifndef MATRIXFILE_H
+#define MATRIXFILE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <charconv>
+#include <vector>
+
+#include "grid2d.h"
+
+#define MATRIX_MAGIC   "HEATMTX"     /* 7 characters + '\0' */
+#define MATRIX_ENDIAN  0x01020304u   /* Reads as 0x04030201 if swapped */
+#define MATRIX_DOUBLE  1             /* Element type: IEEE 754 double */
+
+struct MatrixFileHeader {
+	char magic[8];      /* MATRIX_MAGIC */
+	uint32_t endian;    /* MATRIX_ENDIAN */
+	uint32_t dtype;     /* MATRIX_DOUBLE */
+	uint64_t rows;      /* Number of rows */
+	uint64_t cols;      /* Number of columns */
+};
+
+/*
+** Header for a matrix of doubles with the given size.
+*/
+inline MatrixFileHeader matrixHeader(uint64_t rows, uint64_t cols)
+{
+	MatrixFileHeader h;
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, MATRIX_MAGIC, sizeof(h.magic));
+	h.endian = MATRIX_ENDIAN;
+	h.dtype = MATRIX_DOUBLE;
+	h.rows = rows;
+	h.cols = cols;
+	return h;
+}
+
+/*
+** Maximum length of a formatted number (incl. the newline)
+*/
+#define MATRIX_NUMLEN 32
+
+/*
+** Format 'x' with 10 significant digits, followed by a newline, at 'p'.
+** Returns the end of the text.
+*/
+inline char *formatElement(char *p, double x)
+{
+	p = std::to_chars(p, p + MATRIX_NUMLEN - 1, x, std::chars_format::general,
+					  10).ptr;
+	*p++ = '\n';
+	return p;
+}
+
+/*
+** Write the n*n matrix 'a' into the binary file 'name'. The rows are
+** written through a large buffer, i.e., with a few big write() calls.
+** Returns false, if the file can not be written.
+*/
+inline bool writeMatrixBinary(const char *name, Grid2D<double> &a, int n)
+{
+	FILE *f = fopen(name, "wb");
+	if (f == NULL)
+		return false;
+	std::vector<char> buf(1 << 20);
+	setvbuf(f, buf.data(), _IOFBF, buf.size());
+
+	MatrixFileHeader h = matrixHeader(n, n);
+	bool ok = (fwrite(&h, sizeof(h), 1, f) == 1);
+	for (int i = 0; ok && (i < n); i++)
+		ok = (fwrite(a[i], sizeof(double), n, f) == (size_t)n);
+	return (fclose(f) == 0) && ok;
+}
+
+/*
+** Write the n*n matrix 'a' into the text file 'name'. If 'byColumns' is
+** true, the elements are written in the order a[0][0], a[1][0], ...
+** (as in the Lab 2 programs). Reading the matrix column by column would
+** touch a new row (and for large n a new page) with each element, so
+** MATRIX_COLS columns are formatted together, row by row, into separate
+** buffers, which are then written one after the other. Returns false,
+** if the file can not be written.
+*/
+#define MATRIX_COLS 8
+
+inline bool writeMatrixText(const char *name, Grid2D<double> &a, int n,
+							bool byColumns)
+{
+	FILE *f = fopen(name, "w");
+	if (f == NULL)
+		return false;
+
+	int cols = byColumns ? MATRIX_COLS : 1;
+	size_t len = (size_t)n * MATRIX_NUMLEN + 1;   /* Text of one row/column */
+	std::vector<char> buf(cols * len);
+	char *start[MATRIX_COLS], *p[MATRIX_COLS];
+	bool ok = (fprintf(f, "%d\n\n", n) > 0);
+
+	for (int k0 = 0; ok && (k0 < n); k0 += cols) {
+		int nc = (k0 + cols <= n) ? cols : n - k0;
+		for (int c = 0; c < nc; c++)
+			start[c] = p[c] = buf.data() + c * len;
+
+		if (byColumns) {
+			for (int i = 0; i < n; i++) {
+				const double *row = a[i] + k0;
+				for (int c = 0; c < nc; c++)
+					p[c] = formatElement(p[c], row[c]);
+			}
+		}
+		else {
+			const double *row = a[k0];
+			for (int j = 0; j < n; j++)
+				p[0] = formatElement(p[0], row[j]);
+		}
+
+		for (int c = 0; c < nc; c++) {
+			*p[c]++ = '\n';
+			ok = ok && (fwrite(start[c], 1, p[c] - start[c], f) == (size_t)(p[c] - start[c]));
+		}
+	}
+	return (fclose(f) == 0) && ok;
+}
+
+#endif
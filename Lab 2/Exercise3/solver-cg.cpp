@@ -0,0 +1,209 @@
+/*************************************************************************
+** Iterative solver: (preconditioned) conjugate gradients
+**
+** The interior points of the matrix satisfy the linear system
+**   4*a[i][j] - (sum of neighbors) = 0,
+** where the neighbors on the boundary are known values. The system
+** matrix is symmetric positive definite, so the conjugate gradient
+** method can be used. It needs O(n) instead of O(n^2) iterations. The
+** matrix is never stored: the product with a vector is computed with
+** the 5-point stencil.
+**
+** Preconditioner (environment variable CG_PRECOND):
+**   none     plain CG
+**   jacobi   diagonal scaling, M = D. Since the diagonal is constant
+**            (4), this gives exactly the iterations of plain CG.
+**   ssor     symmetric Gauss/Seidel (SSOR with omega = CG_OMEGA,
+**            default 1) in red-black ordering, so that both triangular
+**            solves are parallel (default)
+**
+** The iteration terminates with the same criterion as the Jacobi solver:
+** the maximum change of an element in a Jacobi step would be at most
+** 'eps', i.e., max |residual| / 4 <= eps. The result is the number of
+** CG iterations.
+**
+** Author:   RW
+**
+*************************************************************************/
+
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "grid2d.h"
+
+using namespace std;
+
+/*
+** The iterative computation terminates, if each element would change
+** by at most 'eps' in a Jacobi step.
+*/
+extern double eps;
+
+
+/* Preconditioners ******************************************************* */
+
+enum Precond { NONE, JACOBI, SSOR };
+
+/*
+** z = M^-1 r, returns the scalar product (r,z). For SSOR,
+** M = (D+wL) D^-1 (D+wU) with the points ordered red (i+j even) before
+** black:
+**   forward:   y_red   = r_red / 4
+**              y_black = (r_black + w * sum of red neighbors of y) / 4
+**   backward:  z_black = y_black
+**              z_red   = y_red + w/4 * sum of black neighbors of z
+** Points of one color are independent. The usual factor w*(2-w) of M is
+** left out, since PCG gives the same iterates for any constant multiple
+** of the preconditioner. Each element of z is final after the sweep that
+** writes it last (black: forward, red: backward), so (r,z) is summed up
+** there instead of in a separate pass. The boundary of z is 0.
+*/
+static double precondition(Precond pc, double omega, Grid2D<double> &z,
+						   Grid2D<double> &r, int n)
+{
+	int i, j;
+	double rz = 0;
+
+	if (pc != SSOR) {
+		double s = (pc == JACOBI) ? 0.25 : 1.0;
+		#pragma omp parallel for private(i, j) reduction(+: rz)
+		for (i=1; i<n-1; i++) {
+			for (j=1; j<n-1; j++) {
+				z[i][j] = s * r[i][j];
+				rz += r[i][j] * z[i][j];
+			}
+		}
+		return rz;
+	}
+
+	#pragma omp parallel private(i, j)
+	{
+		#pragma omp for
+		for (i=1; i<n-1; i++) {
+			for (j=(i%2 == 1) ? 1 : 2; j<n-1; j+=2)
+				z[i][j] = 0.25 * r[i][j];
+		}
+		#pragma omp for reduction(+: rz)
+		for (i=1; i<n-1; i++) {
+			for (j=(i%2 == 1) ? 2 : 1; j<n-1; j+=2) {
+				z[i][j] = 0.25 * (r[i][j] + omega * (z[i][j-1] + z[i-1][j]
+													 + z[i+1][j] + z[i][j+1]));
+				rz += r[i][j] * z[i][j];
+			}
+		}
+		#pragma omp for reduction(+: rz)
+		for (i=1; i<n-1; i++) {
+			for (j=(i%2 == 1) ? 1 : 2; j<n-1; j+=2) {
+				z[i][j] += 0.25 * omega * (z[i][j-1] + z[i-1][j]
+										   + z[i+1][j] + z[i][j+1]);
+				rz += r[i][j] * z[i][j];
+			}
+		}
+	}
+	return rz;
+}
+
+
+/* CG iteration ********************************************************* */
+
+/*
+** Execute (preconditioned) CG iterations on the n*n matrix 'a'.
+*/
+int solver(Grid2D<double> &a, int n)
+{
+	int i, j;
+	int k = 0;          /* Counts iterations */
+	double rz, pq;      /* Scalar products (r,z) and (p,q) */
+	double rmax;        /* Maximum norm of the residual */
+	Grid2D<double> r(n,n), z(n,n), p(n,n), q(n,n);
+
+	if ((r.data() == NULL) || (z.data() == NULL) || (p.data() == NULL)
+		|| (q.data() == NULL)) {
+		cerr << "CG: Can't allocate matrix\n";
+		exit(1);
+	}
+
+	Precond pc = SSOR;
+	const char *env = getenv("CG_PRECOND");
+	if (env != NULL)
+		pc = (strcmp(env, "none") == 0) ? NONE : (strcmp(env, "jacobi") == 0) ? JACOBI : SSOR;
+	double omega = 1.0;
+	env = getenv("CG_OMEGA");
+	if (env != NULL)
+		omega = atof(env);
+	if ((omega <= 0) || (omega >= 2)) {
+		cerr << "CG: omega must be in (0, 2)\n";
+		exit(1);
+	}
+
+	/*
+	** Initial residual r = b - A*a (the boundary values are part of 'b').
+	** All vectors are 0 on the boundary.
+	*/
+	rmax = 0;
+	#pragma omp parallel for private(i, j) reduction(max: rmax)
+	for (i=0; i<n; i++) {
+		for (j=0; j<n; j++) {
+			r[i][j] = z[i][j] = p[i][j] = q[i][j] = 0;
+			if ((i > 0) && (i < n-1) && (j > 0) && (j < n-1)) {
+				r[i][j] = a[i][j-1] + a[i-1][j] + a[i+1][j] + a[i][j+1]
+					- 4 * a[i][j];
+				if (fabs(r[i][j]) > rmax)
+					rmax = fabs(r[i][j]);
+			}
+		}
+	}
+
+	rz = precondition(pc, omega, z, r, n);
+	#pragma omp parallel for private(i, j)
+	for (i=1; i<n-1; i++) {
+		for (j=1; j<n-1; j++)
+			p[i][j] = z[i][j];
+	}
+
+	/*
+	** Iterate until the residual is small enough
+	*/
+	while (0.25 * rmax > eps) {
+		/* q = A*p, pq = (p,q) */
+		pq = 0;
+		#pragma omp parallel for private(i, j) reduction(+: pq)
+		for (i=1; i<n-1; i++) {
+			for (j=1; j<n-1; j++) {
+				q[i][j] = 4 * p[i][j] - (p[i][j-1] + p[i-1][j]
+										 + p[i+1][j] + p[i][j+1]);
+				pq += p[i][j] * q[i][j];
+			}
+		}
+		double alpha = rz / pq;
+
+		/* a += alpha*p, r -= alpha*q */
+		rmax = 0;
+		#pragma omp parallel for private(i, j) reduction(max: rmax)
+		for (i=1; i<n-1; i++) {
+			for (j=1; j<n-1; j++) {
+				a[i][j] += alpha * p[i][j];
+				r[i][j] -= alpha * q[i][j];
+				if (fabs(r[i][j]) > rmax)
+					rmax = fabs(r[i][j]);
+			}
+		}
+		k++;
+		if (0.25 * rmax <= eps)
+			break;
+
+		/* z = M^-1 r, new search direction p = z + beta*p */
+		double rzNew = precondition(pc, omega, z, r, n);
+		double beta = rzNew / rz;
+		rz = rzNew;
+		#pragma omp parallel for private(i, j)
+		for (i=1; i<n-1; i++) {
+			for (j=1; j<n-1; j++)
+				p[i][j] = z[i][j] + beta * p[i][j];
+		}
+	}
+
+	return k;
+}
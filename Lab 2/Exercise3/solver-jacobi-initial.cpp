@@ -9,6 +9,9 @@
 #include <stdlib.h>
 #include <math.h>
 
+#include "grid2d.h"
+#include "instrument.h"
+
 using namespace std;
 
 
@@ -19,26 +22,20 @@ using namespace std;
 extern double eps;
 
 
-/* Auxiliary Functions *************************************************** */
-
-extern double ** New_Matrix(int m, int n);
-extern void Delete_Matrix(double **matrix);
-
-
 /* Jacobi iteration ***************************************************** */
 
 /*
 ** Execute Jacobi iteration on the n*n matrix 'a'.
 */
-int solver(double **a, int n)
+int solver(Grid2D<double> &a, int n)
 {
 	int i,j;
 	double h;
 	double diff;    /* Maximum change since the last iteration */
 	int k = 0;      /* Counts iterations (for statistics only ...) */
-	double **b = New_Matrix(n,n);  /* Auxiliary matrix for result */
+	Grid2D<double> b(n,n);  /* Auxiliary matrix for result */
 
-	if (b == NULL) {
+	if (b.data() == NULL) {
 		cerr << "Jacobi: Can't allocate matrix\n";
 		exit(1);
 	}
@@ -50,6 +47,7 @@ int solver(double **a, int n)
 	do {
 		diff = 0;
 
+		PHASE_BEGIN(tsweep);
 		for (i=1; i<n-1; i++) {
 			for (j=1; j<n-1; j++) {
 				b[i][j] = 0.25 * (a[i][j-1] + a[i-1][j]
@@ -62,19 +60,21 @@ int solver(double **a, int n)
 			}
 		}
 
+		PHASE_END(tsweep, PHASE_SWEEP);
+
 		/*
 		** Copy intermediate result into matrix 'a'
 		*/
+		PHASE_BEGIN(tcopy);
 		for (i=1; i<n-1; i++) {
 			for (j=1; j<n-1; j++) {
 				a[i][j] = b[i][j];
 			}
 		}
+		PHASE_END(tcopy, PHASE_COPY);
 
 		k++;
 	} while (diff > eps);
-	
-	Delete_Matrix(b);
 
 	return k;
 }
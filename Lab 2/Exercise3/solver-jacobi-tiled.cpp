@@ -0,0 +1,228 @@
+/*************************************************************************
+** Iterative solver: Jacobi method, temporally tiled
+**
+** The plain Jacobi solver streams the whole matrix through the memory
+** once per iteration. Here, the rows are split into bands of TILE_ROWS
+** rows, and TILE_STEPS iterations are executed on a band while it is
+** in the cache (trapezoid tiling):
+**
+**   Phase 1: each band executes the iterations t = 0 .. TILE_STEPS-1 on
+**            the rows [L+t, R-t), i.e., the band shrinks by one row on
+**            each side per iteration (not at the matrix boundary).
+**   Phase 2: the triangles between two bands are filled up, i.e., at
+**            the band boundary B the rows [B-t, B+t) are computed.
+**
+** Both phases run in parallel over the bands. Only two matrices are used
+** (alternating between 'a' and 'b'), and each element is computed with
+** exactly the same expression as in the plain solver, so the results are
+** bit-identical.
+**
+** Convergence is checked once per block of TILE_STEPS iterations, using
+** the maximum change of each single iteration in the block. If the
+** required accuracy was reached before the end of the block, the block
+** is recomputed from a checkpoint up to this iteration, so the number of
+** iterations is exactly the same as with the plain solver.
+**
+** Environment variables (or the options --tile-steps / --tile-rows):
+**   TILE_STEPS  iterations per block (default 4)
+**   TILE_ROWS   rows per band (default 32)
+**
+** Author:   RW
+**
+*************************************************************************/
+
+#include <iostream>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+
+#include "grid2d.h"
+#include "stencil.h"
+#include "instrument.h"
+
+using namespace std;
+
+/*
+** Default number of iterations per block, and number of rows per band.
+** The number of rows is at least 2*TILE_STEPS.
+*/
+#ifndef TILE_STEPS
+#define TILE_STEPS 4
+#endif
+#ifndef TILE_ROWS
+#define TILE_ROWS 32
+#endif
+
+/*
+** The iterative computation terminates, if each element has changed
+** by at most 'eps', as compared to the last iteration.
+*/
+extern double eps;
+
+
+/* Auxiliary Functions *************************************************** */
+
+/*
+** Compute the rows [lo, hi) of 'dst' from 'src' and return the maximum
+** change of an element.
+*/
+static inline double sweep(Grid2D<double> &dst, Grid2D<double> &src,
+						   int lo, int hi, int n)
+{
+	double diff = 0;
+	for (int i=lo; i<hi; i++) {
+		double h = jacobi_row(dst[i], src[i-1], src[i], src[i+1], n);
+		if (h > diff)
+			diff = h;
+	}
+	return diff;
+}
+
+
+/* Jacobi iteration ***************************************************** */
+
+/*
+** Execute Jacobi iteration on the n*n matrix 'a'.
+*/
+int solver(Grid2D<double> &a, int n)
+{
+	const char *env = getenv("TILE_STEPS");
+	const int T = ((env != NULL) && (atoi(env) > 0)) ? atoi(env) : TILE_STEPS;
+	env = getenv("TILE_ROWS");
+	const int R0 = ((env != NULL) && (atoi(env) > 0)) ? atoi(env) : TILE_ROWS;
+	const int W = (R0 >= 2*T) ? R0 : 2*T;
+	int i, j, t;
+	int k = 0;      /* Counts iterations */
+	int conv = -1;  /* Iteration of the block in which 'eps' was reached */
+	vector<double> dv(T);
+	double *d = dv.data();  /* Maximum change in each iteration of a block */
+	Grid2D<double> b(n,n);     /* Second matrix for the iterations */
+	Grid2D<double> save(n,n);  /* Checkpoint at the begin of a block */
+	Grid2D<double> *m[2];
+
+	if ((b.data() == NULL) || (save.data() == NULL)) {
+		cerr << "Jacobi: Can't allocate matrix\n";
+		exit(1);
+	}
+
+	/*
+	** The boundary is never changed, so it is copied into 'b' once.
+	*/
+	PHASE_BEGIN(tinit);
+	#pragma omp parallel for private(i, j)
+	for (i=0; i<n; i++) {
+		for (j=0; j<n; j++) {
+			b[i][j] = a[i][j];
+		}
+	}
+	PHASE_END(tinit, PHASE_COPY);
+
+	/*
+	** Bands: rows [1 + p*W, 1 + (p+1)*W). The last band also takes the
+	** remaining rows up to n-1, so no band is smaller than W rows.
+	*/
+	int nbands = (n - 2) / W;
+	if (nbands < 1)
+		nbands = 1;
+
+	/*
+	** At the begin of each block, the current values are in m[0].
+	*/
+	m[0] = &a;
+	m[1] = &b;
+	while (conv < 0) {
+		/* Checkpoint */
+		PHASE_BEGIN(tcopy);
+		#pragma omp parallel for private(i, j)
+		for (i=1; i<n-1; i++) {
+			for (j=1; j<n-1; j++) {
+				save[i][j] = (*m[0])[i][j];
+			}
+		}
+		PHASE_END(tcopy, PHASE_COPY);
+		for (t=0; t<T; t++)
+			d[t] = 0;
+
+		/* Phase 1: shrinking trapezoids in each band */
+		PHASE_BEGIN(tsweep);
+		#pragma omp parallel for private(t) reduction(max: d[:T]) schedule(static)
+		for (int p=0; p<nbands; p++) {
+			int L = 1 + p*W;
+			int R = (p == nbands-1) ? n-1 : L + W;
+			for (t=0; t<T; t++) {
+				int lo = (L == 1) ? 1 : L + t;
+				int hi = (R == n-1) ? n-1 : R - t;
+				if (lo < hi) {
+					double h = sweep(*m[(t+1)%2], *m[t%2], lo, hi, n);
+					if (h > d[t])
+						d[t] = h;
+				}
+			}
+		}
+
+		/* Phase 2: fill the triangles at the band boundaries */
+		#pragma omp parallel for private(t) reduction(max: d[:T]) schedule(static)
+		for (int p=1; p<nbands; p++) {
+			int B = 1 + p*W;
+			for (t=1; t<T; t++) {
+				double h = sweep(*m[(t+1)%2], *m[t%2], B - t, B + t, n);
+				if (h > d[t])
+					d[t] = h;
+			}
+		}
+		PHASE_END(tsweep, PHASE_SWEEP);
+
+		/* Convergence check for each iteration of the block */
+		for (t=0; t<T; t++) {
+			if (d[t] <= eps) {
+				conv = t;
+				break;
+			}
+		}
+
+		if (conv < 0) {
+			k += T;
+			if (T % 2 != 0) {
+				Grid2D<double> *h = m[0];
+				m[0] = m[1];
+				m[1] = h;
+			}
+		}
+		else if (conv < T-1) {
+			/*
+			** The accuracy was reached within the block: restart from the
+			** checkpoint and stop after iteration 'conv'.
+			*/
+			PHASE_BEGIN(trestore);
+			#pragma omp parallel for private(i, j)
+			for (i=1; i<n-1; i++) {
+				for (j=1; j<n-1; j++) {
+					(*m[0])[i][j] = save[i][j];
+				}
+			}
+			PHASE_END(trestore, PHASE_COPY);
+			PHASE_BEGIN(tredo);
+			for (t=0; t<=conv; t++) {
+				#pragma omp parallel for
+				for (int p=0; p<nbands; p++) {
+					int L = 1 + p*W;
+					int R = (p == nbands-1) ? n-1 : L + W;
+					sweep(*m[(t+1)%2], *m[t%2], L, R, n);
+				}
+			}
+			PHASE_END(tredo, PHASE_SWEEP);
+			k += conv + 1;
+		}
+		else {
+			k += T;
+		}
+	}
+
+	/*
+	** The result of the last iteration is in m[(conv+1)%2]
+	*/
+	if (m[(conv+1)%2] != &a)
+		a.swap(b);
+
+	return k;
+}
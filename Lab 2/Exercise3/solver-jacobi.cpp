@@ -9,6 +9,11 @@
 #include <stdlib.h>
 #include <math.h>
 
+#include "grid2d.h"
+#include "stencil.h"
+#include "checkinterval.h"
+#include "instrument.h"
+
 using namespace std;
 
 
@@ -19,65 +24,74 @@ using namespace std;
 extern double eps;
 
 
-/* Auxiliary Functions *************************************************** */
-
-extern double ** New_Matrix(int m, int n);
-extern void Delete_Matrix(double **matrix);
-
-
 /* Jacobi iteration ***************************************************** */
 
 /*
 ** Execute Jacobi iteration on the n*n matrix 'a'.
 */
-int solver(double **a, int n)
+int solver(Grid2D<double> &a, int n)
 {
 	int i,j;
-	double h;
 	double diff;    /* Maximum change since the last iteration */
+	bool done;
 	int k = 0;      /* Counts iterations (for statistics only ...) */
-	double **b = New_Matrix(n,n);  /* Auxiliary matrix for result */
+	Grid2D<double> b(n,n);  /* Auxiliary matrix for result */
+	CheckInterval ci;       /* When to compute 'diff' (see checkinterval.h) */
 
-	if (b == NULL) {
+	if (b.data() == NULL) {
 		cerr << "Jacobi: Can't allocate matrix\n";
 		exit(1);
 	}
+
+	/*
+	** The boundary is never changed, so it is copied into 'b' once.
+	** Afterwards, 'a' and 'b' just swap their roles in each iteration.
+	*/
+	PHASE_BEGIN(tcopy);
+	#pragma omp parallel for private(i, j)
+	for (i=0; i<n; i++) {
+		for (j=0; j<n; j++) {
+			b[i][j] = a[i][j];
+		}
+	}
+	PHASE_END(tcopy, PHASE_COPY);
 	
 	/*
 	** Iterate until convergence is achieved. Here: until the maximum
-	** change of a matrix element is smaller or equal than 'eps'.
+	** change of a matrix element is smaller or equal than 'eps'. The
+	** change is only computed in some iterations (see checkinterval.h).
 	*/
 	do {
-		diff = 0;
-		#pragma omp parallel for private(i, j, h)
-		for (i=1; i<n-1; i++) {
-			for (j=1; j<n-1; j++) {
-				b[i][j] = 0.25 * (a[i][j-1] + a[i-1][j]
-								  + a[i+1][j] + a[i][j+1]);
-
-				/* Determine the maximum change of the matrix elements */
-				h = fabs(a[i][j] - b[i][j]);
+		k++;
+		done = false;
+		PHASE_BEGIN(tsweep);
+		if (ci.check(k)) {
+			diff = 0;
+			#pragma omp parallel for private(i) reduction(max: diff)
+			for (i=1; i<n-1; i++) {
+				/*
+				** Vectorized update of row i, returns the maximum change
+				** of the row's elements (see stencil.h)
+				*/
+				double h = jacobi_row(b[i], a[i-1], a[i], a[i+1], n);
 				if (h > diff)
-					#pragma omp critical
 					diff = h;
 			}
+			done = ci.done(k, diff, eps);
+		}
+		else {
+			#pragma omp parallel for private(i)
+			for (i=1; i<n-1; i++)
+				jacobi_update_row(b[i], a[i-1], a[i], a[i+1], n);
 		}
+		PHASE_END(tsweep, PHASE_SWEEP);
 
 		/*
-		** Copy intermediate result into matrix 'a'
+		** The result of this iteration is the input of the next one
+		** (only the memory blocks are exchanged)
 		*/
-		#pragma omp parallel for private(i, j)
-		for (i=1; i<n-1; i++) {
-			for (j=1; j<n-1; j++) {
-				a[i][j] = b[i][j];
-			}
-		}
-
-		k++;
-	} while (diff > eps);
-	
-	Delete_Matrix(b);
+		a.swap(b);
+	} while (!done);
 
 	return k;
 }
-
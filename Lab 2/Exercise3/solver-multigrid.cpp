@@ -0,0 +1,279 @@
+/*************************************************************************
+** Iterative solver: geometric multigrid (V-cycle)
+**
+** Jacobi and Gauss/Seidel only reduce the smooth (long wave) part of the
+** error very slowly, so they need O(n^2) iterations. Multigrid reduces
+** this part on coarser grids, where it is no longer smooth:
+**
+**   - Smoothing:     red-black Gauss/Seidel sweeps with the 5-point
+**                    stencil, u = 0.25 * (sum of neighbors + g)
+**   - Restriction:   the residual is transferred to a grid with about
+**                    half the number of points in each dimension
+**                    (full weighting, i.e., transposed interpolation)
+**   - Prolongation:  the correction from the coarse grid is bilinearly
+**                    interpolated and added to the fine grid
+**
+** The coarse grids need not be nested: coarse point I is at fine position
+** I*(n-1)/(nc-1), so every matrix size n can be used. For n = 2^k+1, this
+** is the standard nested multigrid.
+**
+** The iteration terminates with the same criterion as the Jacobi solver:
+** the maximum change of an element in a Jacobi step would be at most
+** 'eps', i.e., max |0.25*(sum of neighbors) - a[i][j]| <= eps. The result
+** is the number of V-cycles.
+**
+** Author:   RW
+**
+*************************************************************************/
+
+#include <iostream>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+
+#include "grid2d.h"
+
+using namespace std;
+
+/*
+** Number of smoothing sweeps before and after the coarse grid correction,
+** and on the coarsest grid.
+*/
+#ifndef MG_PRE
+#define MG_PRE 2
+#endif
+#ifndef MG_POST
+#define MG_POST 2
+#endif
+#ifndef MG_COARSE
+#define MG_COARSE 50
+#endif
+
+/*
+** The iterative computation terminates, if each element would change
+** by at most 'eps' in a Jacobi step.
+*/
+extern double eps;
+
+
+/* Grid hierarchy ******************************************************** */
+
+/*
+** One level of the hierarchy. Level 0 is the original matrix. On all
+** levels, the equation 4*u[i][j] - (sum of neighbors) = g[i][j] is
+** solved, with u = 0 on the boundary (except on level 0).
+*/
+struct Level {
+	int n;               /* Size of the grid (incl. boundary) */
+	Grid2D<double> u;    /* Solution (level 0: not used, see solver()) */
+	Grid2D<double> g;    /* Right hand side */
+	Grid2D<double> r;    /* Residual */
+	Grid2D<double> t;    /* Intermediate result of the restriction */
+};
+
+/*
+** Position of fine index i (of nf) on the coarse grid with nc points.
+*/
+static inline double coarsePos(int i, int nf, int nc)
+{
+	return (double)i * (nc - 1) / (nf - 1);
+}
+
+/*
+** Red-black Gauss/Seidel sweeps on u with right hand side g.
+*/
+static void smooth(Grid2D<double> &u, Grid2D<double> &g, int n, int sweeps)
+{
+	for (int s = 0; s < sweeps; s++) {
+		for (int c = 0; c < 2; c++) {
+			#pragma omp parallel for schedule(static)
+			for (int i = 1; i < n - 1; i++) {
+				for (int j = ((i + 1) % 2 == c) ? 1 : 2; j < n - 1; j += 2) {
+					u[i][j] = 0.25 * (u[i][j-1] + u[i-1][j] + u[i+1][j]
+									  + u[i][j+1] + g[i][j]);
+				}
+			}
+		}
+	}
+}
+
+/*
+** r = g - (4*u - sum of neighbors)
+*/
+static void residual(Grid2D<double> &r, Grid2D<double> &u, Grid2D<double> &g, int n)
+{
+	#pragma omp parallel for schedule(static)
+	for (int i = 1; i < n - 1; i++) {
+		for (int j = 1; j < n - 1; j++) {
+			r[i][j] = g[i][j] - (4 * u[i][j] - (u[i][j-1] + u[i-1][j]
+												+ u[i+1][j] + u[i][j+1]));
+		}
+	}
+}
+
+/*
+** Coarse right hand side: gc = P^T r, where P is the bilinear
+** interpolation (see prolongation()). The weight of a fine point for coarse
+** point I is max(0, 1 - |x - I|), where x is its coarse position. This is
+** done in two passes, first along the rows and then along the columns.
+*/
+static void restriction(Level &f, Level &c)
+{
+	int nf = f.n, nc = c.n;
+	double scale = (double)(nf - 1) / (nc - 1);
+
+	#pragma omp parallel for schedule(static)
+	for (int i = 1; i < nf - 1; i++) {
+		for (int J = 1; J < nc - 1; J++) {
+			int jlo = (int)ceil((J - 1) * scale), jhi = (int)floor((J + 1) * scale);
+			double s = 0;
+			for (int j = (jlo < 1) ? 1 : jlo; j <= jhi && j < nf - 1; j++) {
+				double w = 1 - fabs(coarsePos(j, nf, nc) - J);
+				if (w > 0)
+					s += w * f.r[i][j];
+			}
+			f.t[i][J] = s;
+		}
+	}
+
+	#pragma omp parallel for schedule(static)
+	for (int I = 1; I < nc - 1; I++) {
+		int ilo = (int)ceil((I - 1) * scale), ihi = (int)floor((I + 1) * scale);
+		for (int J = 1; J < nc - 1; J++)
+			c.g[I][J] = 0;
+		for (int i = (ilo < 1) ? 1 : ilo; i <= ihi && i < nf - 1; i++) {
+			double w = 1 - fabs(coarsePos(i, nf, nc) - I);
+			if (w > 0) {
+				for (int J = 1; J < nc - 1; J++)
+					c.g[I][J] += w * f.t[i][J];
+			}
+		}
+	}
+}
+
+/*
+** u += P uc, with bilinear interpolation of the coarse correction.
+*/
+static void prolongation(Grid2D<double> &u, Level &f, Level &c)
+{
+	int nf = f.n, nc = c.n;
+
+	#pragma omp parallel for schedule(static)
+	for (int i = 1; i < nf - 1; i++) {
+		double x = coarsePos(i, nf, nc);
+		int I = (int)x;
+		double wx = x - I;
+		for (int j = 1; j < nf - 1; j++) {
+			double y = coarsePos(j, nf, nc);
+			int J = (int)y;
+			double wy = y - J;
+			double e = (1 - wx) * (1 - wy) * c.u[I][J];
+			if (wx > 0)
+				e += wx * (1 - wy) * c.u[I+1][J];
+			if (wy > 0)
+				e += (1 - wx) * wy * c.u[I][J+1];
+			if ((wx > 0) && (wy > 0))
+				e += wx * wy * c.u[I+1][J+1];
+			u[i][j] += e;
+		}
+	}
+}
+
+/*
+** One V-cycle on level l with solution 'u'.
+*/
+static void vcycle(vector<Level> &lv, unsigned int l, Grid2D<double> &u)
+{
+	Level &f = lv[l];
+
+	if (l == lv.size() - 1) {
+		smooth(u, f.g, f.n, MG_COARSE);
+		return;
+	}
+	Level &c = lv[l+1];
+
+	smooth(u, f.g, f.n, MG_PRE);
+	residual(f.r, u, f.g, f.n);
+	restriction(f, c);
+
+	/* Coarse grid: start with a zero correction */
+	#pragma omp parallel for schedule(static)
+	for (int i = 0; i < c.n; i++) {
+		for (int j = 0; j < c.n; j++)
+			c.u[i][j] = 0;
+	}
+	vcycle(lv, l + 1, c.u);
+
+	prolongation(u, f, c);
+	smooth(u, f.g, f.n, MG_POST);
+}
+
+
+/* Multigrid iteration ************************************************** */
+
+/*
+** Execute multigrid V-cycles on the n*n matrix 'a'.
+*/
+int solver(Grid2D<double> &a, int n)
+{
+	int k = 0;      /* Counts V-cycles */
+	double diff;    /* Maximum change in a Jacobi step */
+	vector<Level> lv;
+
+	/*
+	** Build the hierarchy: halve the number of intervals until only a
+	** few interior points are left.
+	*/
+	for (int m = n; ; m = (m - 1) / 2 + 1) {
+		Level l;
+		l.n = m;
+		l.g = Grid2D<double>(m, m);
+		l.r = Grid2D<double>(m, m);
+		if (lv.size() > 0)
+			l.u = Grid2D<double>(m, m);
+		if ((l.g.data() == NULL) || (l.r.data() == NULL)
+			|| ((lv.size() > 0) && (l.u.data() == NULL))) {
+			cerr << "Multigrid: Can't allocate matrix\n";
+			exit(1);
+		}
+		for (int i = 0; i < m; i++) {
+			for (int j = 0; j < m; j++) {
+				l.g[i][j] = 0;
+				l.r[i][j] = 0;
+			}
+		}
+		lv.push_back(std::move(l));
+		if (m <= 5)
+			break;
+	}
+
+	/*
+	** Matrix for the first pass of the restriction (fine rows, coarse
+	** columns)
+	*/
+	for (unsigned int l = 0; l + 1 < lv.size(); l++) {
+		lv[l].t = Grid2D<double>(lv[l].n, lv[l+1].n);
+		if (lv[l].t.data() == NULL) {
+			cerr << "Multigrid: Can't allocate matrix\n";
+			exit(1);
+		}
+	}
+
+	do {
+		vcycle(lv, 0, a);
+		k++;
+
+		diff = 0;
+		#pragma omp parallel for reduction(max: diff)
+		for (int i = 1; i < n - 1; i++) {
+			for (int j = 1; j < n - 1; j++) {
+				double h = fabs(0.25 * (a[i][j-1] + a[i-1][j] + a[i+1][j]
+										+ a[i][j+1]) - a[i][j]);
+				if (h > diff)
+					diff = h;
+			}
+		}
+	} while (diff > eps);
+
+	return k;
+}
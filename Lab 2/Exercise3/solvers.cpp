@@ -0,0 +1,93 @@
+/*************************************************************************
+** Registry of the solvers for heat-all
+**
+** heat-all contains all solvers of Lab 2 in one program, so they can be
+** compared with the same initialization, output and measurement. Each
+** solver source is compiled with -Dsolver=solver_<name> (see makefile),
+** i.e., the solvers themselves are unchanged. The solver() called by
+** heat.cpp runs the selected one.
+**
+** The solver is selected with the option --solver=<name> or the
+** environment variable HEAT_SOLVER (default: jacobi).
+**
+** Author:   RW
+**
+*************************************************************************/
+
+#include <iostream>
+#include <iomanip>
+#include <string.h>
+
+#include "grid2d.h"
+
+using namespace std;
+
+extern int solver_jacobi(Grid2D<double> &a, int n);
+extern int solver_jacobi_tiled(Grid2D<double> &a, int n);
+extern int solver_gs_wavefront(Grid2D<double> &a, int n);
+extern int solver_gs_redblack(Grid2D<double> &a, int n);
+extern int solver_gs_cond(Grid2D<double> &a, int n);
+extern int solver_sor(Grid2D<double> &a, int n);
+extern int solver_sor_redblack(Grid2D<double> &a, int n);
+extern int solver_cg(Grid2D<double> &a, int n);
+extern int solver_multigrid(Grid2D<double> &a, int n);
+
+struct SolverEntry {
+	const char *name;
+	int (*run)(Grid2D<double> &a, int n);
+	const char *description;
+};
+
+static const SolverEntry registry[] = {
+	{ "jacobi",       solver_jacobi,       "Jacobi (Exercise3)" },
+	{ "jacobi-tiled", solver_jacobi_tiled, "Jacobi, temporally tiled (Exercise3)" },
+	{ "gs-wavefront", solver_gs_wavefront, "Gauss/Seidel, wavefront (Exercise4)" },
+	{ "gs-redblack",  solver_gs_redblack,  "Gauss/Seidel, red-black (Exercise4)" },
+	{ "gs-cond",      solver_gs_cond,      "Gauss/Seidel, pipeline with condition variables (Exercise5)" },
+	{ "sor",          solver_sor,          "SOR, wavefront (Exercise4)" },
+	{ "sor-redblack", solver_sor_redblack, "SOR, red-black (Exercise4)" },
+	{ "cg",           solver_cg,           "Conjugate gradients (Exercise3)" },
+	{ "multigrid",    solver_multigrid,    "Multigrid V-cycles (Exercise3)" },
+};
+
+static const SolverEntry *selected = &registry[0];
+
+/*
+** Select the solver 'name'. Returns false, if there is no such solver.
+*/
+bool selectSolver(const char *name)
+{
+	for (const SolverEntry &s : registry) {
+		if (strcmp(s.name, name) == 0) {
+			selected = &s;
+			return true;
+		}
+	}
+	return false;
+}
+
+/*
+** Name of the selected solver
+*/
+const char *solverName()
+{
+	return selected->name;
+}
+
+/*
+** Print the names and descriptions of all solvers.
+*/
+void listSolvers(ostream &os)
+{
+	for (const SolverEntry &s : registry)
+		os << "   " << left << setw(14) << s.name << s.description << "\n";
+	os << right;
+}
+
+/*
+** Execute the selected solver on the n*n matrix 'a'.
+*/
+int solver(Grid2D<double> &a, int n)
+{
+	return selected->run(a, n);
+}
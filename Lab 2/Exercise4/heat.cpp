@@ -4,19 +4,31 @@
 ** 
 ** Compile:  g++ -fopenmp -o heat heat.c solver.c
 **           g++ -fopenmp -O -o heat heat.c solver.c  // with optimization
-** Run:      heat <size> [<epsilon>]
+** Run:      heat [<options>] <size> [<epsilon>]
 **		        <size>      -- Size of matrix
 **	           	<epsilon>   -- accuracy parameter
+**		        <options>   -- see Usage() below
+**
+**           With -DSOLVER_REGISTRY (heat-all), the program contains all
+**           solvers, and --solver selects one (see solvers.cpp).
 ** Author:   RW
 ** 
 *************************************************************************/
 
 #include <iostream>
 #include <iomanip>
-#include <fstream>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include <sys/time.h>
+#include <string>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "grid2d.h"
+#include "matrixfile.h"
+#include "instrument.h"
 
 using namespace std;
 
@@ -30,57 +42,24 @@ double eps = 0.001;
 /*
 ** Execute the iterative solver on the n*n matrix 'a'.
 */
-extern int solver(double **a, int n);
-	
-
-/* Auxiliary Functions ************************************************* */
+extern int solver(Grid2D<double> &a, int n);
 
+#ifdef SOLVER_REGISTRY
 /*
-** Allocate a 2D array with m * n elements (m rows with n columns).
-** I.e., something like ``new double[m][n]'' ...
+** Selection of the solver (see solvers.cpp)
 */
-double ** New_Matrix(int m, int n)
-{
-	double **res;
-	double *array;
-	int i;
-
-	/*
-	** Result is a 1D array with pointers to the rows of the 2D array
-	*/
-	res = new double*[m];
-
-	/*
-    ** The actual array is allocated in one piece for efficiency reasons.
-	** This corresponds to the memory layout that it would have with static
-    ** allocation.
-	*/
-	array = new double[m*n];
-
-	/*
-	** Each row pointer is now initialized with the correct value.
-	** (Row i starts at element i*n)
-	*/
-	for (i = 0; i < m; i++) {
-		res[i] = &array[i * n];
-	}
-
-	return res;
-}
+extern bool selectSolver(const char *name);
+extern const char *solverName();
+extern void listSolvers(ostream &os);
+#endif
+	
 
-/*
-** Deallocate a 2D array.
-*/
-void Delete_Matrix(double **matrix)
-{
-	delete[] matrix[0];
-	delete[] matrix;
-}
+/* Auxiliary Functions ************************************************* */
 
 /*
 ** Auxiliary function: Print an element of a 2D array.
 */
-void print(double **a, int x, int y)
+void print(Grid2D<double> &a, int x, int y)
 {
 	cout << "  a[" << setw(4) << x << "][" << setw(4) << y << "] = "
 		 << setw(0) << setprecision(18) << a[x][y] << "\n";
@@ -99,33 +78,115 @@ double getTime()
 /* File output ******************************************************** */
 
 /*
-** Write the n*n matrix 'a' into the file 'Matrix.txt'.
+** Write the n*n matrix 'a' into a file (see matrixfile.h). The format is
+** selected with the environment variable MATRIX_OUTPUT:
+**   auto     Matrix.txt, if n <= 1000 (default)
+**   binary   Matrix.bin
+**   text     Matrix.txt for ViewMatrix (column by column, i.e.,
+**            a[0][0], a[1][0], ...)
+**   none     no output
+** ViewMatrix reads only the text format.
 */
-void Write_Matrix(double **a, int n)
+void Write_Matrix(Grid2D<double> &a, int n)
 {
-	int i, j;
-	/* Open file for writing */
-	fstream file("Matrix.txt", ios::out|ios::trunc);
-	
-	if (!file.is_open()) {
-		cerr << "Cannot open file 'Matrix.txt' for writing!";
+	const char *env = getenv("MATRIX_OUTPUT");
+	bool text = true;
+	if ((env == NULL) || (strcmp(env, "auto") == 0)) {
+		if (n > 1000)
+			return;
+	}
+	else if (strcmp(env, "none") == 0)
+		return;
+	else
+		text = (strcmp(env, "text") == 0);
+	const char *name = text ? "Matrix.txt" : "Matrix.bin";
+	double t = getTime();
+	bool ok = text ? writeMatrixText(name, a, n, true) : writeMatrixBinary(name, a, n);
+	if (!ok) {
+		cerr << "Cannot write file '" << name << "'!";
 		exit(1);
 	}
+	t = getTime() - t;
+
+	double mb = 1e-6 * n * n * sizeof(double);
+	cout << fixed << setprecision(3) << "Output: " << name << ", " << t
+		 << " s, " << (mb / t) << " MB/s (" << mb << " MB of data)\n"
+		 << defaultfloat;
+}
 
-	/* Write the size of the matrix */
-	file << n << "\n\n";
+/* Command line options ************************************************ */
 
-	/* Write the matrix elements into the file, row by row */
-	file << setprecision(10);
-	for (j = 0; j < n; j++) {
-		for (i = 0; i < n; i++) {
-			file << a[i][j] << "\n";
-		}
-		file << "\n";
+/*
+** Options --<name>=<value>. Except for --threads, an option just sets
+** the environment variable of the setting, i.e., it has the same effect
+** as the environment variable, and takes precedence over it.
+*/
+struct Option {
+	const char *name;
+	const char *env;    /* Environment variable (NULL for --threads) */
+	const char *help;
+};
+
+static const Option options[] = {
+#ifdef SOLVER_REGISTRY
+	{ "solver",         "HEAT_SOLVER",    "solver (--solver=list shows all)" },
+#endif
+	{ "threads",        NULL,             "number of OpenMP threads" },
+	{ "output",         "MATRIX_OUTPUT",  "matrix file: auto, binary, text or none" },
+	{ "omega",          "SOR_OMEGA",      "optimal, adaptive or a number (SOR)" },
+	{ "sor-check",      "SOR_CHECK",      "residual check interval (SOR)" },
+	{ "padding",        "GRID_PADDING",   "0: rows without padding" },
+};
+
+void Usage()
+{
+	cerr << "Usage: heat [<options>] <size> [<epsilon>] !\n\n"
+		 << "   <size>      -- Size of matrix\n"
+		 << "   <epsilon>   -- accuracy parameter\n\n"
+		 << "Options:\n";
+	for (const Option &o : options) {
+		string s = string("--") + o.name + "=...";
+		cerr << "   " << left << setw(24) << s << o.help << "\n";
 	}
+	exit(1);
+}
+
+/*
+** Process the options and remove them from 'argv'.
+*/
+void Parse_Options(int &argc, char **argv)
+{
+	int i, m = 1;
 
-	/* Close file */
-	file.close();
+	for (i=1; i<argc; i++) {
+		if (strncmp(argv[i], "--", 2) != 0) {
+			argv[m++] = argv[i];
+			continue;
+		}
+		const char *name = argv[i] + 2;
+		const char *value = strchr(name, '=');
+		const Option *opt = NULL;
+		if (value != NULL) {
+			for (const Option &o : options) {
+				if ((strlen(o.name) == (size_t)(value - name)) &&
+					(strncmp(o.name, name, value - name) == 0))
+					opt = &o;
+			}
+		}
+		if (opt == NULL) {
+			cerr << "Error: unknown option '" << argv[i] << "'!\n\n";
+			Usage();
+		}
+		value++;
+		if (opt->env != NULL)
+			setenv(opt->env, value, 1);
+		else if (atoi(value) > 0) {
+#ifdef _OPENMP
+			omp_set_num_threads(atoi(value));
+#endif
+		}
+	}
+	argc = m;
 }
 
 /* *********************************************************************** */
@@ -135,15 +196,28 @@ main(int argc, char **argv)
 {
 	int i, j;
 	int n;
-	double **a;
 	double start, end;
 
-	if ((argc < 2) || (argc > 3)) {
-		cerr << "Usage: heat <size> [<epsilon>] !\n\n"
-			 << "   <size>      -- Size of matrix\n"
-			 << "   <epsilon>   -- accuracy parameter\n";
+	Parse_Options(argc, argv);
+#ifdef SOLVER_REGISTRY
+	const char *name = getenv("HEAT_SOLVER");
+	if ((name != NULL) && (strcmp(name, "list") == 0)) {
+		listSolvers(cout);
+		return 0;
+	}
+#endif
+
+	if ((argc < 2) || (argc > 3))
+		Usage();
+
+#ifdef SOLVER_REGISTRY
+	if ((name != NULL) && !selectSolver(name)) {
+		cerr << "Error: unknown solver '" << name << "'! Solvers:\n";
+		listSolvers(cerr);
 		exit(1);
 	}
+	cout << "Solver: " << solverName() << "\n";
+#endif
 
 	/*
 	** First argument: size of the matrix
@@ -169,8 +243,8 @@ main(int argc, char **argv)
 	/*
 	** Allocate new matrix
 	*/
-	a = New_Matrix(n, n);
-	if (a == NULL) {
+	Grid2D<double> a(n, n);
+	if (a.data() == NULL) {
 		cerr << "Can't allocate matrix !\n";
 		exit(1);
 	}
@@ -201,16 +275,21 @@ main(int argc, char **argv)
 	/*
 	** Call the iterative solver on matrix 'a'
 	*/
+#ifdef INSTRUMENT
+	PerfCounters counters;
+	counters.start();
+#endif
 	start = getTime();
 	int niter = solver(a, n);
 	end = getTime();
+#ifdef INSTRUMENT
+	counters.stop();
+#endif
 
 	/*
 	** Write the matrix into a file
 	*/
-	if (n <= 1000) {
-		Write_Matrix(a, n);
-	}
+	Write_Matrix(a, n);
 
 	/*
 	** Statistics and some verification values
@@ -226,6 +305,9 @@ main(int argc, char **argv)
 	double time = (end-start);
 	cout << fixed << setprecision(3) << "Runtime: " << time << " s\n";
 	cout << "Performance: " << (1e-9*niter*(n-2)*(n-2)*4/time) << " GFlop/s\n";
+#ifdef INSTRUMENT
+	instrumentReport(counters.value, phaseTime, (double)niter*(n-2)*(n-2), time);
+#endif
 	return 0;
 }
 
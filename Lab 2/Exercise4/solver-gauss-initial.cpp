@@ -8,24 +8,20 @@
 #include <stdlib.h>
 #include <math.h>
 
+#include "grid2d.h"
+
 /*
 ** The iterative computation terminates, if the accuracy is at least 'eps'.
 */
 extern double eps;
 
 
-/* Auxiliary Functions *************************************************** */
-
-extern double ** New_Matrix(int m, int n);
-extern void Delete_Matrix(double **matrix);
-
-
 /* Gauss/Seidel relaxation *********************************************** */
 
 /*
 ** Execute Gau/Seidel relaxation on the n*n matrix 'a'.
 */
-int solver(double **a, int n)
+int solver(Grid2D<double> &a, int n)
 {
 	/*
 	** Simple estimation for the number of iterations, which is needed to
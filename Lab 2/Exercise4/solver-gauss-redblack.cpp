@@ -0,0 +1,94 @@
+/*************************************************************************
+** Iterative solver: Gauss/Seidel method, red-black ordering
+**
+** The points of the matrix are colored like a checkerboard: a[i][j] is
+** red, if (i+j) is even, and black otherwise. The 5-point stencil of a
+** red point only contains black neighbors and vice versa. So in each
+** iteration, first all red points and then all black points can be
+** updated in parallel, with one barrier per color (instead of 2n for
+** the wavefront over the anti-diagonals). Each thread processes whole
+** rows, using the vectorized kernel from stencil.h.
+**
+** The result is not the same as with the lexicographic ordering, but
+** the convergence rate is the same for this problem (both orderings
+** are "consistent orderings", see e.g. Young, Iterative Solution of
+** Large Linear Systems).
+**
+** With -DSOR, the updates are over-relaxed, and the iteration terminates
+** when the required accuracy is reached (see sor.h).
+**
+** Author:   RW
+**
+*************************************************************************/
+
+#include <stdlib.h>
+#include <math.h>
+
+#include "grid2d.h"
+#include "instrument.h"
+#include "stencil.h"
+#ifdef SOR
+#include <climits>
+#include "sor.h"
+#endif
+
+/*
+** The iterative computation terminates, if the accuracy is at least 'eps'.
+*/
+extern double eps;
+
+/* Gauss/Seidel relaxation *********************************************** */
+
+/*
+** Execute red-black Gauss/Seidel relaxation on the n*n matrix 'a'.
+*/
+int solver(Grid2D<double> &a, int n)
+{
+#ifdef SOR
+	/*
+	** Iterate until the required accuracy is reached (see sor.h).
+	*/
+	SORControl sor(n);
+	int kmax = INT_MAX;
+#else
+	/*
+	** Simple estimation for the number of iterations, which is needed to
+	** achieve the required accuracy.
+	*/
+	int kmax = (int)(0.35 / eps);
+#endif
+	int i, k, c;
+	double omega = 1.0;
+
+	/*
+	** Iterate 'k' times.
+	*/
+	for (k = 0; k < kmax; k++) {
+#ifdef SOR
+		omega = sor.omega();
+#endif
+		PHASE_BEGIN(tsweep);
+		/*
+		** c = 0: red points, c = 1: black points. In row i, the first
+		** point of color c is in column 1 or 2.
+		*/
+		#pragma omp parallel private(i, c)
+		for (c = 0; c < 2; c++) {
+			#pragma omp for schedule(static)
+			for (i = 1; i < n - 1; i++) {
+				int first = ((i + 1) % 2 == c) ? 1 : 2;
+				redblack_row(a[i], a[i - 1], a[i + 1], n, first, omega);
+			}
+		}
+		PHASE_END(tsweep, PHASE_SWEEP);
+#ifdef SOR
+		PHASE_BEGIN(tcheck);
+		bool done = sor.done(a, n, k + 1, eps);
+		PHASE_END(tcheck, PHASE_REDUCE);
+		if (done)
+			return k + 1;
+#endif
+	}
+
+	return kmax;
+}
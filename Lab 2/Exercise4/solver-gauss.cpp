@@ -8,47 +8,77 @@
 #include <stdlib.h>
 #include <math.h>
 
+#include "grid2d.h"
+#include "instrument.h"
+#ifdef SOR
+#include <climits>
+#include "sor.h"
+#endif
+
 /*
 ** The iterative computation terminates, if the accuracy is at least 'eps'.
 */
 extern double eps;
 
-/* Auxiliary Functions *************************************************** */
-
-extern double **New_Matrix(int m, int n);
-extern void Delete_Matrix(double **matrix);
-
 /* Gauss/Seidel relaxation *********************************************** */
 
 /*
 ** Execute Gau�/Seidel relaxation on the n*n matrix 'a'.
 */
-int solver(double **a, int n)
+int solver(Grid2D<double> &a, int n)
 {
+#ifdef SOR
+	/*
+	** Iterate until the required accuracy is reached (see sor.h).
+	*/
+	SORControl sor(n);
+	int kmax = INT_MAX;
+#else
 	/*
 	** Simple estimation for the number of iterations, which is needed to
 	** achieve the required accuracy.
 	*/
 	int kmax = (int)(0.35 / eps);
+#endif
 	int i, j, ij;
 	int k; /* Counts iterations */
+	double omega = 1.0;
 
 	/*
 	** Iterate 'k' times.
 	*/
 	for (k = 0; k < kmax; k++)
 	{
-		#pragma omp parallel for private(ij, j, i)
+#ifdef SOR
+		omega = sor.omega();
+#endif
+		PHASE_BEGIN(tsweep);
+		/*
+		** Wavefront: the elements of an anti-diagonal only depend on the
+		** previous one, so they can be updated in parallel. The diagonals
+		** must be processed one after the other (barrier of 'omp for').
+		*/
+		#pragma omp parallel private(ij, j, i)
 		for (ij = 1; ij < 2 * n - 4; ij++)
 		{
 			int ja = (ij <= n - 2) ? 1 : ij - (n - 3);
 			int je = (ij <= n - 2) ? ij : n - 2;
+			#pragma omp for
 			for (j = ja; j <= je; j++)
 			{
 				i = ij - j + 1;
-				a[i][j] = 0.25 * (a[i][j - 1] + a[i - 1][j] + a[i + 1][j] + a[i][j + 1]);
+				double v = 0.25 * (a[i][j - 1] + a[i - 1][j] + a[i + 1][j] + a[i][j + 1]);
+				a[i][j] = (omega == 1.0) ? v : a[i][j] + omega * (v - a[i][j]);
 			}
 		}
+		PHASE_END(tsweep, PHASE_SWEEP);
+#ifdef SOR
+		PHASE_BEGIN(tcheck);
+		bool done = sor.done(a, n, k + 1, eps);
+		PHASE_END(tcheck, PHASE_REDUCE);
+		if (done)
+			return k + 1;
+#endif
 	}
 	
 	return kmax;
@@ -0,0 +1,133 @@
+/*************************************************************************
+** Control of the successive over-relaxation (SOR)
+**
+** With SOR, each update is extrapolated:
+**   a[i][j] = old + omega * (gauss_seidel_value - old)
+** For the Dirichlet problem on the square, the optimal value is
+**   omega = 2 / (1 + sin(pi / (n-1)))
+** (e.g., Young, Iterative Solution of Large Linear Systems), which holds
+** for the lexicographic/wavefront and for the red-black ordering.
+**
+** Environment variables:
+**   SOR_OMEGA   a number, "optimal" (default) or "adaptive". With
+**               "adaptive", omega = 1 (Gauss/Seidel) is used, until the
+**               convergence factor lambda of Gauss/Seidel can be estimated
+**               from the residuals. Then omega = 2 / (1 + sqrt(1-lambda)).
+**               SOR_OMEGA=1 gives plain Gauss/Seidel.
+**   SOR_CHECK   the residual is computed every SOR_CHECK sweeps (default 10)
+**
+** The iteration terminates with the same criterion as the Jacobi solver:
+** the maximum change of an element in a Jacobi step would be at most
+** 'eps', i.e., max |0.25*(sum of neighbors) - a[i][j]| <= eps. Since this
+** is only checked every SOR_CHECK sweeps, up to SOR_CHECK-1 more sweeps
+** than necessary are executed.
+**
+** Author:   RW
+**
+*************************************************************************/
+
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "grid2d.h"
+
+class SORControl
+{
+public:
+	/*
+	** Constructor for an n*n matrix.
+	*/
+	SORControl(int n)
+	{
+		const char *env = getenv("SOR_CHECK");
+		check = (env != NULL) ? atoi(env) : 10;
+		if (check < 1)
+			check = 1;
+
+		adaptive = false;
+		w = 2 / (1 + sin(M_PI / (n - 1)));
+		env = getenv("SOR_OMEGA");
+		if ((env != NULL) && (strcmp(env, "adaptive") == 0)) {
+			adaptive = true;
+			w = 1;
+		}
+		else if ((env != NULL) && (strcmp(env, "optimal") != 0)) {
+			w = atof(env);
+			if ((w <= 0) || (w >= 2)) {
+				std::cerr << "SOR: omega must be in (0, 2)\n";
+				exit(1);
+			}
+		}
+		lastRes = lambda = 0;
+		checks = 0;
+	}
+
+	/*
+	** The relaxation parameter for the next sweep.
+	*/
+	double omega() const
+	{
+		return w;
+	}
+
+	/*
+	** Must be called after sweep 'k' (counting from 1). Returns true, if
+	** the required accuracy 'eps' has been reached.
+	*/
+	bool done(Grid2D<double> &a, int n, int k, double eps)
+	{
+		if (k % check != 0)
+			return false;
+
+		double res = residual(a, n);
+		if (res <= eps) {
+			std::cout << "SOR: omega = " << w << "\n";
+			return true;
+		}
+
+		/*
+		** Adaptive omega: estimate the convergence factor per sweep of
+		** Gauss/Seidel, until two successive estimates agree.
+		*/
+		if (adaptive && (lastRes > 0)) {
+			double l = pow(res / lastRes, 1.0 / check);
+			if ((l < 1) && (fabs(l - lambda) < 0.01 * (1 - l))) {
+				w = 2 / (1 + sqrt(1 - l));
+				adaptive = false;
+			}
+			lambda = l;
+			if (++checks >= 50)
+				adaptive = false;  /* No stable estimate, keep omega = 1 */
+		}
+		lastRes = res;
+		return false;
+	}
+
+private:
+	double w;        /* Relaxation parameter */
+	int check;       /* Residual check interval (in sweeps) */
+	bool adaptive;   /* Still estimating omega? */
+	double lastRes;  /* Residual at the last check */
+	double lambda;   /* Last estimate of the convergence factor */
+	int checks;      /* Number of estimates */
+
+	/*
+	** Maximum change of an element in a Jacobi step.
+	*/
+	static double residual(Grid2D<double> &a, int n)
+	{
+		double res = 0;
+		#pragma omp parallel for reduction(max: res)
+		for (int i = 1; i < n - 1; i++) {
+			for (int j = 1; j < n - 1; j++) {
+				double h = fabs(0.25 * (a[i][j-1] + a[i-1][j] + a[i+1][j]
+										+ a[i][j+1]) - a[i][j]);
+				if (h > res)
+					res = h;
+			}
+		}
+		return res;
+	}
+};
@@ -0,0 +1,355 @@
+/*************************************************************************
+** Vectorized row kernels for the 5-point stencil
+**
+** See stencil.h for a description. The AVX2 and AVX-512 versions are
+** compiled with a 'target' attribute, so no special compiler options
+** are needed; they are only called if the CPU supports them.
+**
+*************************************************************************/
+
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <immintrin.h>
+
+#include "stencil.h"
+
+
+/* Scalar versions ****************************************************** */
+
+static double jacobi_row_scalar(double * __restrict dst,
+								const double * __restrict up,
+								const double * __restrict mid,
+								const double * __restrict down, int n)
+{
+	double diff = 0;
+	for (int j=1; j<n-1; j++) {
+		dst[j] = 0.25 * (mid[j-1] + up[j] + down[j] + mid[j+1]);
+		double h = fabs(mid[j] - dst[j]);
+		if (h > diff)
+			diff = h;
+	}
+	return diff;
+}
+
+static void jacobi_update_row_scalar(double * __restrict dst,
+									 const double * __restrict up,
+									 const double * __restrict mid,
+									 const double * __restrict down, int n)
+{
+	for (int j=1; j<n-1; j++)
+		dst[j] = 0.25 * (mid[j-1] + up[j] + down[j] + mid[j+1]);
+}
+
+static double redblack_row_scalar(double *mid, const double * __restrict up,
+								  const double * __restrict down, int n,
+								  int first, double omega)
+{
+	double diff = 0;
+	for (int j=first; j<n-1; j+=2) {
+		double old = mid[j];
+		double v = 0.25 * (mid[j-1] + up[j] + down[j] + mid[j+1]);
+		mid[j] = (omega == 1.0) ? v : old + omega * (v - old);
+		double h = fabs(old - mid[j]);
+		if (h > diff)
+			diff = h;
+	}
+	return diff;
+}
+
+
+/* AVX2 versions (4 elements per vector) ******************************** */
+
+__attribute__((target("avx2")))
+static double jacobi_row_avx2(double * __restrict dst,
+							  const double * __restrict up,
+							  const double * __restrict mid,
+							  const double * __restrict down, int n)
+{
+	const __m256d quarter = _mm256_set1_pd(0.25);
+	const __m256d sign = _mm256_set1_pd(-0.0);
+	__m256d vdiff = _mm256_setzero_pd();
+	int j;
+
+	for (j=1; j+4<=n-1; j+=4) {
+		__m256d s = _mm256_add_pd(_mm256_loadu_pd(&mid[j-1]),
+								  _mm256_loadu_pd(&up[j]));
+		s = _mm256_add_pd(s, _mm256_loadu_pd(&down[j]));
+		s = _mm256_add_pd(s, _mm256_loadu_pd(&mid[j+1]));
+		__m256d v = _mm256_mul_pd(quarter, s);
+		_mm256_storeu_pd(&dst[j], v);
+		__m256d h = _mm256_andnot_pd(sign,
+									 _mm256_sub_pd(_mm256_loadu_pd(&mid[j]), v));
+		vdiff = _mm256_max_pd(vdiff, h);
+	}
+
+	double d[4];
+	_mm256_storeu_pd(d, vdiff);
+	double diff = d[0];
+	for (int l=1; l<4; l++) {
+		if (d[l] > diff)
+			diff = d[l];
+	}
+
+	/* Remaining elements */
+	for (; j<n-1; j++) {
+		dst[j] = 0.25 * (mid[j-1] + up[j] + down[j] + mid[j+1]);
+		double h = fabs(mid[j] - dst[j]);
+		if (h > diff)
+			diff = h;
+	}
+	return diff;
+}
+
+__attribute__((target("avx2")))
+static void jacobi_update_row_avx2(double * __restrict dst,
+								   const double * __restrict up,
+								   const double * __restrict mid,
+								   const double * __restrict down, int n)
+{
+	const __m256d quarter = _mm256_set1_pd(0.25);
+	int j;
+
+	for (j=1; j+4<=n-1; j+=4) {
+		__m256d s = _mm256_add_pd(_mm256_loadu_pd(&mid[j-1]),
+								  _mm256_loadu_pd(&up[j]));
+		s = _mm256_add_pd(s, _mm256_loadu_pd(&down[j]));
+		s = _mm256_add_pd(s, _mm256_loadu_pd(&mid[j+1]));
+		_mm256_storeu_pd(&dst[j], _mm256_mul_pd(quarter, s));
+	}
+	for (; j<n-1; j++)
+		dst[j] = 0.25 * (mid[j-1] + up[j] + down[j] + mid[j+1]);
+}
+
+__attribute__((target("avx2")))
+static double redblack_row_avx2(double *mid, const double * __restrict up,
+								const double * __restrict down, int n,
+								int first, double omega)
+{
+	const __m256d quarter = _mm256_set1_pd(0.25);
+	const __m256d sign = _mm256_set1_pd(-0.0);
+	/* Only the lanes 0 and 2 (i.e., j and j+2) have the current color */
+	const __m256i mask = _mm256_set_epi64x(0, -1, 0, -1);
+	const __m256d w = _mm256_set1_pd(omega);
+	__m256d vdiff = _mm256_setzero_pd();
+	int j = first;
+
+	/*
+	** The left and right neighbors have the other color, so they are not
+	** changed in this row. They are taken from the vectors 'prev', 'cur'
+	** and 'next', which were loaded before the preceding masked store.
+	** (Loading them from memory again would overlap with this store, and
+	** the load would have to wait until the store has been completed.)
+	** Only lane 3 of 'prev' is used. 'cur' is only loaded if the loop is
+	** executed, since a short row may end before mid[j+3].
+	*/
+	__m256d prev = _mm256_set1_pd(mid[j-1]);
+	__m256d cur = _mm256_setzero_pd();
+	if (j+8 <= n)
+		cur = _mm256_loadu_pd(&mid[j]);
+	for (; j+8<=n; j+=4) {
+		__m256d next = _mm256_loadu_pd(&mid[j+4]);
+		__m256d left = _mm256_shuffle_pd(_mm256_permute2f128_pd(prev, cur, 0x21),
+										 cur, 5);
+		__m256d right = _mm256_shuffle_pd(cur,
+										  _mm256_permute2f128_pd(cur, next, 0x21), 5);
+		__m256d s = _mm256_add_pd(left, _mm256_loadu_pd(&up[j]));
+		s = _mm256_add_pd(s, _mm256_loadu_pd(&down[j]));
+		s = _mm256_add_pd(s, right);
+		__m256d v = _mm256_mul_pd(quarter, s);
+		if (omega != 1.0)
+			v = _mm256_add_pd(cur, _mm256_mul_pd(w, _mm256_sub_pd(v, cur)));
+		_mm256_maskstore_pd(&mid[j], mask, v);
+		__m256d h = _mm256_andnot_pd(sign, _mm256_sub_pd(cur, v));
+		vdiff = _mm256_max_pd(vdiff, _mm256_and_pd(h, _mm256_castsi256_pd(mask)));
+		prev = cur;
+		cur = next;
+	}
+
+	double d[4];
+	_mm256_storeu_pd(d, vdiff);
+	double diff = d[0];
+	for (int l=1; l<4; l++) {
+		if (d[l] > diff)
+			diff = d[l];
+	}
+
+	/* Remaining elements */
+	for (; j<n-1; j+=2) {
+		double old = mid[j];
+		double v = 0.25 * (mid[j-1] + up[j] + down[j] + mid[j+1]);
+		mid[j] = (omega == 1.0) ? v : old + omega * (v - old);
+		double h = fabs(old - mid[j]);
+		if (h > diff)
+			diff = h;
+	}
+	return diff;
+}
+
+
+/* AVX-512 versions (8 elements per vector) ***************************** */
+
+__attribute__((target("avx512f")))
+static double jacobi_row_avx512(double * __restrict dst,
+								const double * __restrict up,
+								const double * __restrict mid,
+								const double * __restrict down, int n)
+{
+	const __m512d quarter = _mm512_set1_pd(0.25);
+	__m512d vdiff = _mm512_setzero_pd();
+	int j;
+
+	for (j=1; j+8<=n-1; j+=8) {
+		__m512d s = _mm512_add_pd(_mm512_loadu_pd(&mid[j-1]),
+								  _mm512_loadu_pd(&up[j]));
+		s = _mm512_add_pd(s, _mm512_loadu_pd(&down[j]));
+		s = _mm512_add_pd(s, _mm512_loadu_pd(&mid[j+1]));
+		__m512d v = _mm512_mul_pd(quarter, s);
+		_mm512_storeu_pd(&dst[j], v);
+		__m512d h = _mm512_abs_pd(_mm512_sub_pd(_mm512_loadu_pd(&mid[j]), v));
+		vdiff = _mm512_max_pd(vdiff, h);
+	}
+	double diff = _mm512_reduce_max_pd(vdiff);
+
+	/* Remaining elements */
+	for (; j<n-1; j++) {
+		dst[j] = 0.25 * (mid[j-1] + up[j] + down[j] + mid[j+1]);
+		double h = fabs(mid[j] - dst[j]);
+		if (h > diff)
+			diff = h;
+	}
+	return diff;
+}
+
+__attribute__((target("avx512f")))
+static void jacobi_update_row_avx512(double * __restrict dst,
+									 const double * __restrict up,
+									 const double * __restrict mid,
+									 const double * __restrict down, int n)
+{
+	const __m512d quarter = _mm512_set1_pd(0.25);
+	int j;
+
+	for (j=1; j+8<=n-1; j+=8) {
+		__m512d s = _mm512_add_pd(_mm512_loadu_pd(&mid[j-1]),
+								  _mm512_loadu_pd(&up[j]));
+		s = _mm512_add_pd(s, _mm512_loadu_pd(&down[j]));
+		s = _mm512_add_pd(s, _mm512_loadu_pd(&mid[j+1]));
+		_mm512_storeu_pd(&dst[j], _mm512_mul_pd(quarter, s));
+	}
+	for (; j<n-1; j++)
+		dst[j] = 0.25 * (mid[j-1] + up[j] + down[j] + mid[j+1]);
+}
+
+__attribute__((target("avx512f")))
+static double redblack_row_avx512(double *mid, const double * __restrict up,
+								  const double * __restrict down, int n,
+								  int first, double omega)
+{
+	const __m512d quarter = _mm512_set1_pd(0.25);
+	/* Only the even lanes (i.e., j, j+2, ...) have the current color */
+	const __mmask8 mask = 0x55;
+	const __m512d w = _mm512_set1_pd(omega);
+	__m512d vdiff = _mm512_setzero_pd();
+	int j = first;
+
+	/*
+	** As in the AVX2 version, the left and right neighbors are taken from
+	** registers. Only lane 7 of 'prev' is used, and 'cur' is only loaded
+	** if the loop is executed.
+	*/
+	__m512i prev = _mm512_castpd_si512(_mm512_set1_pd(mid[j-1]));
+	__m512i cur = _mm512_setzero_si512();
+	if (j+16 <= n)
+		cur = _mm512_castpd_si512(_mm512_loadu_pd(&mid[j]));
+	for (; j+16<=n; j+=8) {
+		__m512i next = _mm512_castpd_si512(_mm512_loadu_pd(&mid[j+8]));
+		__m512d left = _mm512_castsi512_pd(_mm512_alignr_epi64(cur, prev, 7));
+		__m512d right = _mm512_castsi512_pd(_mm512_alignr_epi64(next, cur, 1));
+		__m512d old = _mm512_castsi512_pd(cur);
+		__m512d s = _mm512_add_pd(left, _mm512_loadu_pd(&up[j]));
+		s = _mm512_add_pd(s, _mm512_loadu_pd(&down[j]));
+		s = _mm512_add_pd(s, right);
+		__m512d v = _mm512_mul_pd(quarter, s);
+		if (omega != 1.0)
+			v = _mm512_add_pd(old, _mm512_mul_pd(w, _mm512_sub_pd(v, old)));
+		_mm512_mask_storeu_pd(&mid[j], mask, v);
+		__m512d h = _mm512_abs_pd(_mm512_sub_pd(old, v));
+		vdiff = _mm512_mask_max_pd(vdiff, mask, vdiff, h);
+		prev = cur;
+		cur = next;
+	}
+	double diff = _mm512_reduce_max_pd(vdiff);
+
+	/* Remaining elements */
+	for (; j<n-1; j+=2) {
+		double old = mid[j];
+		double v = 0.25 * (mid[j-1] + up[j] + down[j] + mid[j+1]);
+		mid[j] = (omega == 1.0) ? v : old + omega * (v - old);
+		double h = fabs(old - mid[j]);
+		if (h > diff)
+			diff = h;
+	}
+	return diff;
+}
+
+
+/* Runtime selection **************************************************** */
+
+/*
+** Returns the best version supported by the CPU, or the version
+** requested with STENCIL_ISA. If the CPU does not support the requested
+** version, the best supported version below it is used. With STENCIL_ISA,
+** the version actually used is printed.
+*/
+static const char * select_isa()
+{
+	const char *isa = getenv("STENCIL_ISA");
+
+	__builtin_cpu_init();
+	bool avx512 = __builtin_cpu_supports("avx512f");
+	bool avx2 = __builtin_cpu_supports("avx2");
+	const char *best = avx512 ? "avx512" : avx2 ? "avx2" : "scalar";
+
+	if ((isa == NULL) || (*isa == '\0'))
+		return best;
+
+	const char *sel;
+	if (strcmp(isa, "scalar") == 0)
+		sel = "scalar";
+	else if (strcmp(isa, "avx2") == 0)
+		sel = avx2 ? "avx2" : "scalar";
+	else if (strcmp(isa, "avx512") == 0)
+		sel = best;
+	else {
+		std::cerr << "Stencil: " << best << " (unknown STENCIL_ISA '"
+				  << isa << "')\n";
+		return best;
+	}
+	std::cerr << "Stencil: " << sel;
+	if (strcmp(sel, isa) != 0)
+		std::cerr << " (STENCIL_ISA=" << isa << " is not supported by the CPU)";
+	std::cerr << "\n";
+	return sel;
+}
+
+const char *stencil_isa = select_isa();
+
+double (*jacobi_row)(double *, const double *, const double *,
+					 const double *, int)
+	= (strcmp(stencil_isa, "avx512") == 0) ? jacobi_row_avx512
+	: (strcmp(stencil_isa, "avx2") == 0) ? jacobi_row_avx2
+	: jacobi_row_scalar;
+
+void (*jacobi_update_row)(double *, const double *, const double *,
+						  const double *, int)
+	= (strcmp(stencil_isa, "avx512") == 0) ? jacobi_update_row_avx512
+	: (strcmp(stencil_isa, "avx2") == 0) ? jacobi_update_row_avx2
+	: jacobi_update_row_scalar;
+
+double (*redblack_row)(double *, const double *, const double *, int, int,
+					   double)
+	= (strcmp(stencil_isa, "avx512") == 0) ? redblack_row_avx512
+	: (strcmp(stencil_isa, "avx2") == 0) ? redblack_row_avx2
+	: redblack_row_scalar;
@@ -0,0 +1,50 @@
+/*************************************************************************
+** Vectorized row kernels for the 5-point stencil
+**
+** The solvers access the matrix through 'double **' row pointers, so
+** the compiler can not prove that the rows do not overlap and does not
+** vectorize the stencil loops well. The kernels here work on one row
+** and get the neighboring rows as separate pointers.
+**
+** Each kernel exists in a scalar, an AVX2 and an AVX-512 version. The
+** version is selected once at program start, depending on the CPU.
+** The environment variable STENCIL_ISA (scalar, avx2 or avx512) can be
+** used to select a version, e.g., for comparisons. A version the CPU
+** does not support falls back to the best supported one below it; the
+** version actually used is printed to stderr.
+**
+** All versions compute exactly the same expression as the original
+** solvers, i.e., the results are bit-identical.
+**
+*************************************************************************/
+
+/*
+** Jacobi update of one row:
+**   dst[j] = 0.25 * (mid[j-1] + up[j] + down[j] + mid[j+1])
+** for j = 1 .. n-2. Returns the maximum of |mid[j] - dst[j]|.
+*/
+extern double (*jacobi_row)(double *dst, const double *up, const double *mid,
+							const double *down, int n);
+
+/*
+** The same update without computing the change (for the iterations in
+** which the convergence is not checked).
+*/
+extern void (*jacobi_update_row)(double *dst, const double *up,
+								 const double *mid, const double *down, int n);
+
+/*
+** Red-black Gauss-Seidel update of one row (in place):
+**   mid[j] = 0.25 * (mid[j-1] + up[j] + down[j] + mid[j+1])
+** for j = first, first+2, ... <= n-2 (first is 1 or 2). If omega is not 1,
+** the update is over-relaxed (SOR): mid[j] = old + omega * (new - old).
+** Returns the maximum change of an element.
+*/
+extern double (*redblack_row)(double *mid, const double *up,
+							  const double *down, int n, int first,
+							  double omega);
+
+/*
+** Name of the selected version ("scalar", "avx2" or "avx512").
+*/
+extern const char *stencil_isa;
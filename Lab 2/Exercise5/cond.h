@@ -1,15 +1,36 @@
 /*************************************************************************
 ** Synchronization construct for Gauss/Seidel
 **
+** For each row, the last completed iteration is stored in an atomic
+** counter. signal() stores the counter with release semantics, wait()
+** reads it with acquire semantics, so all elements of the row written
+** before signal() are visible after wait() returns.
+**
+** A waiting thread first spins for a short time (the row is usually
+** completed soon). If the row is still not completed, the thread is
+** blocked using a futex, so it does not occupy a core which might be
+** needed by the thread computing the row. signal() only issues a
+** system call, if a thread is actually blocked on the row.
+**
 ** Author:   RW
-** 
+**
 *************************************************************************/
 
 // Only compile, when compiler is invoked with -fopenmp
 #ifdef _OPENMP
 
 #include <climits>
+#include <atomic>
 #include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+/*
+** Number of polls before a waiting thread is blocked.
+*/
+#ifndef COND_SPIN
+#define COND_SPIN 4000
+#endif
 
 class Cond
 {
@@ -19,11 +40,11 @@ public:
 	*/
 	Cond(int n)
 	{
-		last_iter = new int[n]();
+		row = new Row[n];
 		// Row 0 never changes, and therefore is already computed for any 'k'.
-		last_iter[0] = INT_MAX;
+		row[0].last_iter.store(INT_MAX, std::memory_order_relaxed);
 		//  Row n-1 never changes, and therefore is already computed for any 'k'.
-		last_iter[n-1] = INT_MAX;
+		row[n-1].last_iter.store(INT_MAX, std::memory_order_relaxed);
 	}
 
 	/*
@@ -31,16 +52,23 @@ public:
 	*/
 	~Cond()
 	{
-		delete[] last_iter;
+		delete[] row;
 	}
-		
+
 	/*
 	** Signals that the computation of row 'i' in iteration 'k' has been completed.
 	*/
 	void signal(int k, int i)
 	{
-		last_iter[i] = k+1;
-        #pragma omp flush      // Enforce memory consistency
+		Row &r = row[i];
+		/*
+		** The store and the load of 'waiters' must not be reordered
+		** (otherwise a thread that is just going to sleep might be missed),
+		** therefore both are sequentially consistent, as in wait().
+		*/
+		r.last_iter.store(k+1, std::memory_order_seq_cst);
+		if (r.waiters.load(std::memory_order_seq_cst) > 0)
+			futex(&r.last_iter, FUTEX_WAKE_PRIVATE, INT_MAX);
 	}
 
 	/*
@@ -48,19 +76,44 @@ public:
 	*/
 	void wait(int k, int i)
 	{
-        #pragma omp flush      // Enforce memory consistency
-		while (last_iter[i] < k+1) {
-			usleep(1000);      // Reduces CPU load
-            #pragma omp flush  // Enforce memory consistency
+		Row &r = row[i];
+		for (int s = 0; s < COND_SPIN; s++) {
+			if (r.last_iter.load(std::memory_order_acquire) >= k+1)
+				return;
+			__builtin_ia32_pause();
+		}
+		for (;;) {
+			r.waiters.fetch_add(1, std::memory_order_seq_cst);
+			int v = r.last_iter.load(std::memory_order_seq_cst);
+			if (v < k+1)
+				futex(&r.last_iter, FUTEX_WAIT_PRIVATE, v);
+			r.waiters.fetch_sub(1, std::memory_order_relaxed);
+			if (r.last_iter.load(std::memory_order_acquire) >= k+1)
+				return;
 		}
 	}
 
 private:
-    /*
-	** last_iter[i] is the last iteration 'k', for which row 'i'
-	** has already been computed.
+	/*
+	** last_iter is the last iteration 'k', for which the row has already
+	** been computed. 'waiters' counts the threads blocked on the row.
+	** Each row has its own cache line, since neighboring rows are
+	** usually signaled by different threads.
+	*/
+	struct alignas(64) Row {
+		std::atomic<int> last_iter;
+		std::atomic<int> waiters;
+		Row() : last_iter(0), waiters(0) {}
+	};
+	Row *row;
+
+	/*
+	** futex() system call on an atomic counter (which has the same
+	** representation as an int).
 	*/
-	int *last_iter;
+	static void futex(std::atomic<int> *addr, int op, int val)
+	{
+		syscall(SYS_futex, (int *)addr, op, val, NULL, NULL, 0);
+	}
 };
 #endif
-
@@ -7,52 +7,63 @@
 
 #include <stdlib.h>
 #include <math.h>
+#include <omp.h>
 
 #include "cond.h"
+#include "grid2d.h"
 
 /*
 ** The iterative computation terminates, if the accuracy is at least 'eps'.
 */
 extern double eps;
 
-/* Auxiliary Functions *************************************************** */
-
-extern double **New_Matrix(int m, int n);
-extern void Delete_Matrix(double **matrix);
-
 /* Gauss/Seidel relaxation *********************************************** */
 
 /*
 ** Execute Gau�/Seidel relaxation on the n*n matrix 'a'.
 */
-int solver(double **a, int n)
+int solver(Grid2D<double> &a, int n)
 {
 	/*
 	** Simple estimation for the number of iterations, which is needed to
 	** achieve the required accuracy.
 	*/
 	int kmax = (int)(0.35 / eps);
-	int i, j;
-	int k; /* Counts iterations */
 
 	/*
-	** Iterate k times.
+	** Each thread computes a band of consecutive rows in all iterations.
+	** The bands are pipelined: in iteration k, the first row of a band
+	** needs the last row of the band above in iteration k, and the last
+	** row of a band needs the first row of the band below in iteration
+	** k-1. All other dependencies are within the band. So the result is
+	** exactly the same as with the sequential solver.
 	*/
-
 	Cond cond(n);
-	for (k = 0; k < kmax; k++)
+	#pragma omp parallel
 	{
-		for (i = 1; i < n - 1; i++)
-		{
-			cond.wait(k - 1, i + 1);
-			cond.wait(k, i - 1);
-#pragma omp parallel for schedule(static)
-			for (j = 1; j < n - 1; j++)
-			{
-				int v = 0.25 * (a[i][j - 1] + a[i - 1][j] + a[i + 1][j] + a[i][j + 1]);
-				a[i][j] = v;
+		int nthreads = omp_get_num_threads();
+		int t = omp_get_thread_num();
+		int lo = 1 + (int)((long)t * (n - 2) / nthreads);      /* Band: rows */
+		int hi = 1 + (int)((long)(t + 1) * (n - 2) / nthreads);  /* [lo, hi) */
+		int i, j, k;
+
+		/*
+		** Iterate 'k' times.
+		*/
+		for (k = 0; k < kmax; k++) {
+			for (i = lo; i < hi; i++) {
+				if (i == lo)
+					cond.wait(k, i - 1);
+				if (i == hi - 1)
+					cond.wait(k - 1, i + 1);
+				for (j = 1; j < n - 1; j++) {
+					a[i][j] = 0.25 * (a[i][j - 1] + a[i - 1][j] +
+									  a[i + 1][j] + a[i][j + 1]);
+				}
+				/* Only the boundary rows of the band are waited for */
+				if ((i == lo) || (i == hi - 1))
+					cond.signal(k, i);
 			}
-			cond.signal(k, i);
 		}
 	}
 	return kmax;
@@ -21,7 +21,9 @@ using namespace std;
  * 0 and numConf-1.
  */
 BFSQueue::BFSQueue(unsigned long numConf)
-	: file("sokoban.tmp", ios::out|ios::in|ios::trunc|ios::binary) // open a temporary file
+	: file("sokoban.tmp", ios::out|ios::in|ios::trunc|ios::binary), // open a temporary file
+	  queueAlloc(BLOCKSIZE * sizeof(Entry)),
+	  bitsetAlloc(BLOCKSIZE * sizeof(unsigned int))
 {
 	if (!file.is_open()) {
 		cerr << "Cannot open tmp file 'sokoban.tmp'\n";
@@ -49,13 +51,7 @@ BFSQueue::BFSQueue(unsigned long numConf)
  */
 BFSQueue::~BFSQueue()
 {
-	for (unsigned int i=0; i<queue_length; i++) {
-		delete[] queue[0][i];
-		delete[] queue[1][i];
-	}
-	for (unsigned int i=0; i<bitset_length; i++) {
-		delete[] bitset[i];
-	}
+	// The second-level arrays are released by the destructors of the allocators
 	delete[] queue[0];
 	delete[] queue[1];
 	delete[] bitset;
@@ -98,7 +94,7 @@ bool BFSQueue::lookup_and_add(unsigned long conf, unsigned int predIndex, unsign
 	
 	// If necessary, allocate an array at the second level and initialize it with 0
 	if (bitset[i1] == NULL)
-		bitset[i1] = new unsigned int[BLOCKSIZE]();
+		bitset[i1] = (unsigned int *)bitsetAlloc.alloc();
 
 	// If the configuration is in the bit set: we are done
 	if ((bitset[i1][i2] & bitmask) != 0)
@@ -117,7 +113,7 @@ bool BFSQueue::lookup_and_add(unsigned long conf, unsigned int predIndex, unsign
 
 	// If necessary, allocate an array at the second level and initialize it
 	if (queue[wr][n1] == NULL)
-		queue[wr][n1] = new Entry[BLOCKSIZE]();
+		queue[wr][n1] = (Entry *)queueAlloc.alloc();
 
 	// Write the new entry at position wrPos into the write queue
 	queue[wr][n1][n2].set(conf, wrPos + (rdLength - predIndex), box);
@@ -136,6 +132,15 @@ unsigned int BFSQueue::length()
 	return rdLength;
 }
 
+/**
+ * Return the number of entries written into the write queue so far. This may be called
+ * by another thread while the search is running (e.g., for progress reports).
+ */
+unsigned long BFSQueue::writeLength()
+{
+	return wrPos;
+}
+
 /**
  * Return the i-th entry in the read queue (configuration as return value;
  * moved box in *box).
@@ -176,6 +181,35 @@ unsigned long * BFSQueue::getPath(unsigned long conf, unsigned int predIndex,
 	return path;
 }
 
+/**
+ * Return the current RAM usage for the arrays and the bit set in '*ram' and the
+ * size of the temporary file in '*disk' (in bytes).
+ */
+void BFSQueue::usage(unsigned long * ram, unsigned long * disk)
+{
+	unsigned long size = 2*queue_length*sizeof(Entry *) + bitset_length*sizeof(unsigned int *);
+	for (unsigned int i=0; i<queue_length; i++) {
+		if (queue[0][i] != NULL)
+			size += BLOCKSIZE*sizeof(Entry);
+		if (queue[1][i] != NULL)
+			size += BLOCKSIZE*sizeof(Entry);
+	}
+	for (unsigned int i=0; i<bitset_length; i++) {
+		if (bitset[i] != NULL)
+			size += BLOCKSIZE*sizeof(unsigned int);
+	}
+	*ram = size;
+	*disk = file_length*sizeof(Entry);
+}
+
+/**
+ * Return the size of a queue entry in RAM and in the temporary file (in bytes).
+ */
+unsigned int BFSQueue::entrySize()
+{
+	return sizeof(Entry);
+}
+
 /**
  * Returns information about RAM and hard disk usage.
  */
@@ -1,3 +1,5 @@
+#include "blockalloc.h"
+
 using namespace std;
 
 /**
@@ -91,6 +93,10 @@ class BFSQueue
 	inline unsigned int bsIndex2(unsigned long i) { return (i >> WORDBITS) & BLOCKMASK; }
 	inline unsigned int bsBitPos(unsigned long i) { return i & WORDMASK; }
 
+	// Allocators for the second-level arrays of the queues and the bit set (see blockalloc.h)
+	BlockAlloc queueAlloc;
+	BlockAlloc bitsetAlloc;
+
  public:
 	/**
 	 * Constructor: Create a queue/bit set for configuration numbers between
@@ -121,6 +127,23 @@ class BFSQueue
 	 * Return the length of the read queue.
 	 */
 	unsigned int length();
+
+	/**
+	 * Return the number of entries written into the write queue so far. This may be called
+	 * by another thread while the search is running (e.g., for progress reports).
+	 */
+	unsigned long writeLength();
+
+	/**
+	 * Return the current RAM usage for the arrays and the bit set in '*ram' and the
+	 * size of the temporary file in '*disk' (in bytes).
+	 */
+	void usage(unsigned long * ram, unsigned long * disk);
+
+	/**
+	 * Return the size of a queue entry in RAM and in the temporary file (in bytes).
+	 */
+	static unsigned int entrySize();
 	
 	/**
 	 * Return the i-th entry in the read queue (configuration as return value;
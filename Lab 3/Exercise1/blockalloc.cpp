@@ -0,0 +1,130 @@
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+
+#include <string>
+#include <iostream>
+#include <fstream>
+
+#include "blockalloc.h"
+
+using namespace std;
+
+/**
+ * Allocator for the second-level arrays of the two-level arrays in BFSQueue and DFSDepthMap.
+ * All blocks of one allocator have the same size. They are carved out of large arenas which
+ * are aligned to 2 MB, so that the operating system can back them with transparent huge pages.
+ */
+
+
+// Number of NUMA nodes (1 on non-NUMA systems)
+unsigned int BlockAlloc::nNodes = 0;
+
+/**
+ * Constructor: Creates an allocator for blocks of 'blockSize' bytes.
+ */
+BlockAlloc::BlockAlloc(unsigned long ablockSize)
+{
+	blockSize = ablockSize;
+	blocksPerArena = (blockSize < ARENASIZE) ? ARENASIZE / blockSize : 1;
+	used = blocksPerArena; // forces the allocation of an arena with the first block
+	if (nNodes == 0)
+		nNodes = numNodes();
+}
+
+/**
+ * Destructor: releases all blocks.
+ */
+BlockAlloc::~BlockAlloc()
+{
+	for (unsigned int i=0; i<arenas.size(); i++)
+		munmap(arenas[i], arenaLengths[i]);
+}
+
+/**
+ * Returns a new block initialized with 0. The caller must serialize the calls (see
+ * blockalloc.h).
+ */
+void * BlockAlloc::alloc()
+{
+	if (used == blocksPerArena) {
+		newArena(blocksPerArena * blockSize);
+		used = 0;
+	}
+	void * block = arenas.back() + used * blockSize;
+	used++;
+	return block;
+}
+
+// Allocate a new arena of at least 'length' bytes, aligned to ARENASIZE
+char * BlockAlloc::newArena(unsigned long length)
+{
+	length = (length + ARENASIZE - 1) & ~(ARENASIZE - 1);
+
+	// Anonymous mappings are initialized with 0 and only get physical pages when they are
+	// touched. We map one arena more than needed and cut off the misaligned head and tail.
+	char * p = (char *)mmap(NULL, length + ARENASIZE, PROT_READ|PROT_WRITE,
+							MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+	if (p == MAP_FAILED) {
+		cerr << "BlockAlloc: out of memory\n";
+		exit(1);
+	}
+	char * arena = (char *)(((unsigned long)p + ARENASIZE - 1) & ~(ARENASIZE - 1));
+	if (arena > p)
+		munmap(p, arena - p);
+	if (arena + length < p + length + ARENASIZE)
+		munmap(arena + length, (p + length + ARENASIZE) - (arena + length));
+
+#ifdef HUGEPAGES
+	// Ask for transparent huge pages. This is only a hint, so errors are ignored.
+	madvise(arena, length, MADV_HUGEPAGE);
+#endif
+
+#if NUMA_POLICY != 0
+	// The policy must be set before the pages are touched for the first time.
+	if (nNodes > 1) {
+		unsigned long mask;
+		int mode;
+		if (NUMA_POLICY == 1) {
+			mask = (nNodes >= 64) ? ~0UL : (1UL << nNodes) - 1;
+			mode = MPOL_INTERLEAVE;
+		}
+		else {
+			mask = 1UL << (arenas.size() % nNodes);
+			mode = MPOL_PREFERRED;
+		}
+		syscall(SYS_mbind, arena, length, mode, &mask, 64, 0);
+	}
+#endif
+
+	arenas.push_back(arena);
+	arenaLengths.push_back(length);
+	return arena;
+}
+
+// Determine the number of NUMA nodes
+unsigned int BlockAlloc::numNodes()
+{
+	// The file contains a list of node ranges, e.g. "0-1" or "0,2-3". The highest node
+	// number + 1 is sufficient for building the node masks.
+	ifstream file("/sys/devices/system/node/online");
+	string line;
+	unsigned int n = 1;
+	if (file && getline(file, line)) {
+		unsigned int num = 0;
+		for (unsigned int i=0; i<line.length(); i++) {
+			char c = line[i];
+			if ((c >= '0') && (c <= '9')) {
+				num = num*10 + (c - '0');
+				if (num+1 > n)
+					n = num+1;
+			}
+			else {
+				num = 0;
+			}
+		}
+	}
+	return n;
+}
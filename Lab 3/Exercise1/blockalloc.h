@@ -0,0 +1,77 @@
+#ifndef BLOCKALLOC_H
+#define BLOCKALLOC_H
+
+#include <vector>
+
+using namespace std;
+
+// Back the blocks with 2 MB transparent huge pages. Comment out to use normal 4 KB pages.
+#ifndef NO_HUGEPAGES
+#define HUGEPAGES
+#endif
+
+// Placement of the blocks on a NUMA system (can be overridden with -DNUMA_POLICY=...):
+//  0 = first touch (default of the operating system)
+//  1 = interleaved page by page across all NUMA nodes
+//  2 = partitioned, i.e., each arena is bound to one node, round robin over all nodes
+#ifndef NUMA_POLICY
+#define NUMA_POLICY 0
+#endif
+
+/**
+ * Allocator for the second-level arrays of the two-level arrays in BFSQueue and DFSDepthMap.
+ * All blocks of one allocator have the same size. They are carved out of large arenas which
+ * are aligned to 2 MB, so that the operating system can back them with transparent huge pages.
+ * This considerably reduces the number of TLB misses for the random accesses into the bit set.
+ * Optionally, the arenas are interleaved or partitioned across the NUMA nodes, instead of
+ * being placed on the node of the thread that happens to touch them first.
+ * Blocks are never released individually; all memory is returned in the destructor.
+ */
+class BlockAlloc
+{
+ private:
+	// Size of a huge page, and thus the alignment and size of an arena
+	static const unsigned long ARENASIZE = 2UL << 20;
+
+	// Size of a block in bytes
+	unsigned long blockSize;
+
+	// Number of blocks per arena
+	unsigned long blocksPerArena;
+
+	// Start addresses and lengths of all arenas allocated so far
+	vector<char *> arenas;
+	vector<unsigned long> arenaLengths;
+
+	// Number of blocks already used in the last arena
+	unsigned long used;
+
+	// Number of NUMA nodes (1 on non-NUMA systems)
+	static unsigned int nNodes;
+
+	// Allocate a new arena of at least 'length' bytes, aligned to ARENASIZE
+	char * newArena(unsigned long length);
+
+	// Determine the number of NUMA nodes
+	static unsigned int numNodes();
+
+ public:
+	/**
+	 * Constructor: Creates an allocator for blocks of 'blockSize' bytes.
+	 */
+	BlockAlloc(unsigned long blockSize);
+
+	/**
+	 * Destructor: releases all blocks.
+	 */
+	~BlockAlloc();
+
+	/**
+	 * Returns a new block initialized with 0. The method is not thread safe: all callers
+	 * already hold the 'omp critical' lock around lookup_and_add() / lookup_and_set(),
+	 * so a second lock here would only cost time.
+	 */
+	void * alloc();
+};
+
+#endif
@@ -3,6 +3,7 @@
 
 #include "converter.h"
 #include "config.h"
+#include "pushtables.h"
 
 using namespace std;
 
@@ -30,6 +31,26 @@ static unsigned int log2(unsigned long num)
 Config * Config::init(const char * fname)
 {
 	Playfield::init(fname);
+	return initTables(fname);
+}
+
+/**
+ * Initialization from a level of the XSB collection 'fname', given as one string per row
+ * (see XSBReader). The return value is the start configuration, or NULL if the level can
+ * not be handled by the solver.
+ */
+Config * Config::initXSB(const char * fname, vector<string> & level)
+{
+	if (!Playfield::initXSB(level))
+		return NULL;
+	return initTables(fname);
+}
+
+// Initialize the tables for the current playing field. 'fname' is the name of the
+// level file (used for the sidecar file of PushTables).
+Config * Config::initTables(const char * fname)
+{
+	PushTables::init(fname);
 	Converter::init(Playfield::nPos, Playfield::nBox);
 	nBoxConfigs = Converter::getNumConfigs();
 	solutionConfNo = Converter::configToNo(Playfield::goalPos);
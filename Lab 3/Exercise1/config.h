@@ -26,6 +26,13 @@ class Config
 	 */
 	static Config * init(const char * fname);
 
+	/**
+	 * Initialization from a level of the XSB collection 'fname', given as one string per row
+	 * (see XSBReader). The return value is the start configuration, or NULL if the level can
+	 * not be handled by the solver.
+	 */
+	static Config * initXSB(const char * fname, vector<string> & level);
+
 	/**
 	 * Does the specified configuration number represent a solution, i.e., are all boxes on
 	 * a target?
@@ -104,6 +111,10 @@ class Config
 	// Configuration number of the solution (all boxes are on their target positions)
 	static unsigned long solutionConfNo;
 
+	// Initialize the tables for the current playing field. 'fname' is the name of the
+	// level file (used for the sidecar file of PushTables).
+	static Config * initTables(const char * fname);
+
 
 	// Configuration number of this configuration
 	unsigned long configNo;
@@ -87,6 +87,18 @@ unsigned int Converter::findPos(unsigned int n, unsigned int k, unsigned long no
  */
 void Converter::init(unsigned int n, unsigned int k)
 {
+	// Release the arrays of a previous initialization
+	if (cacheNoverK != NULL) {
+		for (unsigned int i=0; i<maxN; i++) {
+			for (unsigned int j=0; j<maxK; j++)
+				delete[] cacheConfNo[i][j];
+			delete[] cacheConfNo[i];
+			delete[] cacheNoverK[i];
+		}
+		delete[] cacheConfNo;
+		delete[] cacheNoverK;
+	}
+
 	maxN = n;
 	maxK = k;
 	
@@ -19,6 +19,7 @@ using namespace std;
  * 0 and numConf-1 and a maximum depth of 'maxDepth'.
  */
 DFSDepthMap::DFSDepthMap(unsigned long numConf, unsigned int maxDepth)
+	: depthAlloc(BLOCKSIZE)
 {
 	depth_length = index1(numConf-1) + 1;
 	depth = new volatile unsigned char*[depth_length]();
@@ -30,9 +31,7 @@ DFSDepthMap::DFSDepthMap(unsigned long numConf, unsigned int maxDepth)
  */
 DFSDepthMap::~DFSDepthMap()
 {
-	for (unsigned int i=0; i<depth_length; i++) {
-		delete[] depth[i];
-	}
+	// The second-level arrays are released by the destructor of the allocator
 	delete[] depth;
 }
 
@@ -48,7 +47,7 @@ bool DFSDepthMap::lookup_and_set(unsigned long conf, unsigned int newDepth)
 
 	// If necessary, allocate an array at the second level and initialize it with 0
 	if (depth[i1] == NULL)
-		depth[i1] = new unsigned char[BLOCKSIZE]();
+		depth[i1] = (unsigned char *)depthAlloc.alloc();
 	
 	// If there is an entry with equal or smaller depth: we are done
 	unsigned char old = depth[i1][i2];
@@ -64,6 +63,18 @@ bool DFSDepthMap::lookup_and_set(unsigned long conf, unsigned int newDepth)
 	return true;
 }
 
+/**
+ * Returns the number of configurations entered into the map for depths < 'maxDepth'.
+ * This may be called by another thread while the search is running.
+ */
+unsigned long DFSDepthMap::count(unsigned int maxDepth)
+{
+	unsigned long sum = 0;
+	for (unsigned int i=1; i<maxDepth; i++)
+		sum += nConfigs[i];
+	return sum;
+}
+
 /**
  * Returns information about RAM and hard disk usage and the number of
  * examined configurations for all depths < 'maxDepth'.
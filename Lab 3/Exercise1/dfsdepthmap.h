@@ -1,3 +1,5 @@
+#include "blockalloc.h"
+
 using namespace std;
 
 /**
@@ -25,6 +27,9 @@ class DFSDepthMap
 	inline unsigned int index1(unsigned long i)  { return i >> BLOCKBITS; }
 	inline unsigned int index2(unsigned long i)  { return i & BLOCKMASK; }
 
+	// Allocator for the second-level arrays (see blockalloc.h)
+	BlockAlloc depthAlloc;
+
 	// Mapping from configuration number to tree depth, using a two-level array
 	volatile unsigned char * volatile * depth;
 	
@@ -53,6 +58,12 @@ class DFSDepthMap
 	 */
 	bool lookup_and_set(unsigned long conf, unsigned int newDepth);
 
+	/**
+	 * Returns the number of configurations entered into the map for depths < 'maxDepth'.
+	 * This may be called by another thread while the search is running.
+	 */
+	unsigned long count(unsigned int maxDepth);
+
 	/**
 	 * Returns information about RAM and hard disk usage and the number of
 	 * examined configurations for all depths < 'maxDepth'.
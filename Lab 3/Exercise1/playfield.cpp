@@ -1,8 +1,10 @@
 #include <iostream>
 #include <stdlib.h>
 #include <fstream>
+#include <vector>
 
 #include "config.h"
+#include "pushtables.h"
 
 // Ausgabe in Farbe. Fr normale Ausgabe bitte auskommentieren.
 #define COLOR
@@ -142,6 +144,17 @@ void Playfield::init(string field[], unsigned int any)
 	unsigned int playerX = -1;
 	unsigned int playerY;
 
+	// (0) Release the arrays of a previously loaded level
+	if (posNo != NULL) {
+		for (unsigned int y=0; y<ny; y++)
+			delete[] posNo[y];
+		delete[] posNo;
+	}
+	for (unsigned int i=0; i<4; i++)
+		delete[] neighbor[i];
+	delete[] initialBoxPos;
+	delete[] goalPos;
+
 	// (1) Remember the position of the player and remove the player
 	ny = any;
 	nx = field[0].length();
@@ -277,6 +290,143 @@ void Playfield::init(string field[], unsigned int any)
 			goalPos[i++] = p;
 		}
 	}
+
+	delete[] xPos;
+	delete[] yPos;
+}
+
+/**
+ * Initializes the playing field from a level in the standard XSB format (see XSBReader),
+ * given as one string per row. The level is converted to the internal representation:
+ * fields outside of the walls become walls, and fields from which a box can not be pushed
+ * onto any target are marked as dead-ends. Returns false (with an error message), if the
+ * level can not be handled by the solver.
+ */
+bool Playfield::initXSB(vector<string> & rows)
+{
+	// XSB symbols
+	const char xWall = '#', xPlayer = '@', xGoalPlayer = '+', xBox = '$', xGoalBox = '*',
+		xGoal = '.';
+
+	// (1) Copy the rows into a grid with a border of walls, so that each field of the
+	// level has four (possibly wall) neighbors. Floor symbols are unified to ' '.
+	unsigned int w = 0;
+	for (unsigned int y=0; y<rows.size(); y++) {
+		if (rows[y].length() > w)
+			w = rows[y].length();
+	}
+	unsigned int h = rows.size() + 2;
+	w += 2;
+	vector<string> grid(h, string(w, xWall));
+	unsigned int playerX = 0, playerY = 0, nPlayer = 0;
+	for (unsigned int y=0; y<rows.size(); y++) {
+		for (unsigned int x=0; x<w-2; x++) {
+			char c = (x < rows[y].length()) ? rows[y][x] : ' ';
+			if ((c == '-') || (c == '_'))
+				c = ' ';
+			if ((c == xPlayer) || (c == xGoalPlayer)) {
+				playerX = x+1;
+				playerY = y+1;
+				nPlayer++;
+			}
+			grid[y+1][x+1] = c;
+		}
+	}
+	if (nPlayer != 1) {
+		cerr << "Error: level must contain exactly one player!\n";
+		return false;
+	}
+
+	const int dx[4] = { -1, 0, 1, 0 };
+	const int dy[4] = { 0, -1, 0, 1 };
+
+	// (2) The fields that belong to the level are those the player can reach when
+	// ignoring the boxes. Everything else becomes a wall.
+	vector<unsigned char> inside(w*h, 0);
+	vector<unsigned int> queue;
+	queue.push_back(playerY*w + playerX);
+	inside[playerY*w + playerX] = 1;
+	for (unsigned int out=0; out<queue.size(); out++) {
+		unsigned int x = queue[out] % w, y = queue[out] / w;
+		for (unsigned int dir=0; dir<4; dir++) {
+			unsigned int n = (y+dy[dir])*w + (x+dx[dir]);
+			if (!inside[n] && (grid[y+dy[dir]][x+dx[dir]] != xWall)) {
+				inside[n] = 1;
+				queue.push_back(n);
+			}
+		}
+	}
+
+	// (3) Dead-ends: fields from which a box can not be pushed onto any target. This is the
+	// same backward search that computes the push distances (see PushTables::pull()), here
+	// on the grid fields y*w+x with all targets as sources.
+	vector<unsigned int> gridNeighbor[4];
+	for (unsigned int dir=0; dir<4; dir++) {
+		gridNeighbor[dir].assign(w*h, NONE);
+		for (unsigned int i=0; i<w*h; i++) {
+			unsigned int n = i + dy[dir]*(int)w + dx[dir];
+			if (inside[i] && inside[n])
+				gridNeighbor[dir][i] = n;
+		}
+	}
+	unsigned int * const nb[4] = { gridNeighbor[0].data(), gridNeighbor[1].data(),
+								   gridNeighbor[2].data(), gridNeighbor[3].data() };
+	queue.clear();
+	for (unsigned int i=0; i<w*h; i++) {
+		char c = grid[i/w][i%w];
+		if (inside[i] && ((c == xGoal) || (c == xGoalBox) || (c == xGoalPlayer)))
+			queue.push_back(i);
+	}
+	vector<unsigned short> pushes(w*h);
+	PushTables::pull(nb, w*h, w*h, queue.data(), queue.size(), pushes.data());
+
+	// (4) Map the symbols onto the internal representation
+	unsigned int nBoxes = 0, nGoals = 0, nBoxPos = 0;
+	string * field = new string[h];
+	for (unsigned int y=0; y<h; y++) {
+		field[y] = string(w, _wall);
+		for (unsigned int x=0; x<w; x++) {
+			char c = grid[y][x];
+			bool dead = (pushes[y*w+x] == PushTables::INF);
+			if (!inside[y*w+x])
+				continue;
+			if (!dead)
+				nBoxPos++;
+			if ((c == xBox) || (c == xGoalBox))
+				nBoxes++;
+			if ((c == xGoal) || (c == xGoalBox) || (c == xGoalPlayer))
+				nGoals++;
+			if ((c == xBox) && dead) {
+				cerr << "Error: box on a dead-end field, level is unsolvable!\n";
+				delete[] field;
+				return false;
+			}
+			switch (c) {
+			case xPlayer:     field[y][x] = dead ? _deadPlayer : _player; break;
+			case xGoalPlayer: field[y][x] = _goalPlayer; break;
+			case xBox:        field[y][x] = _box; break;
+			case xGoalBox:    field[y][x] = _goalBox; break;
+			case xGoal:       field[y][x] = _goal; break;
+			default:          field[y][x] = dead ? _dead : _empty; break;
+			}
+		}
+	}
+	if ((nBoxes == 0) || (nBoxes != nGoals)) {
+		cerr << "Error: #Boxes != #Goals!\n";
+		delete[] field;
+		return false;
+	}
+	if (nBoxPos > 64) {
+		// Config stores the box positions in a 64 bit set
+		cerr << "Error: level has more than 64 fields for boxes!\n";
+		delete[] field;
+		return false;
+	}
+
+	// (5) Initialize the playing field
+	init(field, h);
+	delete[] field;
+	return true;
 }
 
 
@@ -1,3 +1,5 @@
+#include <vector>
+
 using namespace std;
 
 class Config;
@@ -79,6 +81,12 @@ class Playfield
 	 * Initializes the playing field from the given file.
 	 */
 	static void init(const char * fname);
+
+	/**
+	 * Initializes the playing field from a level in the standard XSB format (see XSBReader),
+	 * given as one string per row. Returns false, if the level can not be handled.
+	 */
+	static bool initXSB(vector<string> & rows);
 		
 	/**
 	 * Is the given position valid, i.e., not a wall?
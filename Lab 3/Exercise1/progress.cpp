@@ -0,0 +1,231 @@
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/time.h>
+
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+
+#include "progress.h"
+#include "bfsqueue.h"
+#include "dfsdepthmap.h"
+
+using namespace std;
+
+/**
+ * This class (with only static attributes and methods) reports the progress of long running
+ * searches. See progress.h for a description of the output.
+ */
+
+
+double Progress::interval = 0;
+double Progress::startTime;
+double Progress::lastTime;
+unsigned long Progress::lastNodes = 0;
+BFSQueue * Progress::queue = NULL;
+DFSDepthMap * Progress::map = NULL;
+unsigned int Progress::depth = 0;
+unsigned long Progress::length = 0;
+unsigned long Progress::prevLength = 0;
+unsigned long Progress::doneNodes = 0;
+unsigned int Progress::maxDepth = 0;
+
+// Mutex protecting the attributes and the output, the reporting thread and its stop flag
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_t thread;
+static volatile bool running = false;
+
+/**
+ * Returns the current wall clock time as a floating point number.
+ */
+static double getTime()
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec * 0.000001;
+}
+
+// ==================================================================
+
+/**
+ * Start the reporting thread, if SOKOBAN_PROGRESS is set.
+ */
+void Progress::start()
+{
+	const char * env = getenv("SOKOBAN_PROGRESS");
+	if ((env == NULL) || (atof(env) <= 0))
+		return;
+	interval = atof(env);
+	startTime = lastTime = getTime();
+	running = true;
+	if (pthread_create(&thread, NULL, run, NULL) != 0) {
+		cerr << "Progress: cannot start reporting thread\n";
+		running = false;
+	}
+}
+
+/**
+ * Stop the reporting thread.
+ */
+void Progress::stop()
+{
+	if (running) {
+		running = false;
+		pthread_join(thread, NULL);
+	}
+	done();
+}
+
+/**
+ * The current search is finished. Must be called before the observed queue or map is
+ * deleted; the reporting thread keeps running for the next search.
+ */
+void Progress::done()
+{
+	pthread_mutex_lock(&mutex);
+	queue = NULL;
+	map = NULL;
+	length = prevLength = doneNodes = lastNodes = 0;
+	pthread_mutex_unlock(&mutex);
+}
+
+/**
+ * Breadth first search: the layer with 'length' configurations of depth 'depth-1' is
+ * going to be examined. The successors are entered into 'queue'.
+ */
+void Progress::bfsDepth(unsigned int adepth, unsigned int alength, BFSQueue * aqueue)
+{
+	if (interval <= 0)
+		return;
+	pthread_mutex_lock(&mutex);
+	queue = aqueue;
+	depth = adepth;
+	prevLength = length;
+	length = alength;
+	doneNodes += alength;
+	report("depth");
+	pthread_mutex_unlock(&mutex);
+}
+
+/**
+ * Depth first search: the search up to depth 'maxDepth' starts, using the mapping 'map'.
+ */
+void Progress::dfsStart(DFSDepthMap * amap, unsigned int amaxDepth)
+{
+	if (interval <= 0)
+		return;
+	pthread_mutex_lock(&mutex);
+	map = amap;
+	maxDepth = amaxDepth;
+	pthread_mutex_unlock(&mutex);
+}
+
+/**
+ * Depth first search: a solution with 'length' pushes has been found.
+ */
+void Progress::dfsSolution(unsigned int alength)
+{
+	if (interval <= 0)
+		return;
+	pthread_mutex_lock(&mutex);
+	maxDepth = alength+1;
+	report("solution");
+	pthread_mutex_unlock(&mutex);
+}
+
+// ==================================================================
+
+// Returns the number of configurations found so far
+unsigned long Progress::nodes()
+{
+	if (queue != NULL)
+		return doneNodes + queue->writeLength();
+	if (map != NULL)
+		return map->count(maxDepth);
+	return 0;
+}
+
+// Returns the resident set size of the process in KBytes
+unsigned long Progress::rss()
+{
+	// The second field of /proc/self/statm is the number of resident pages
+	ifstream statm("/proc/self/statm");
+	unsigned long size = 0, resident = 0;
+	statm >> size >> resident;
+	return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+// Print one line of the report. 'event' is the name of the event.
+void Progress::report(const char * event)
+{
+	double now = getTime();
+	unsigned long n = nodes();
+	double rate = (now > lastTime) ? (n - lastNodes) / (now - lastTime) : 0;
+	lastTime = now;
+	lastNodes = n;
+	bool depthEvent = (string(event) == "depth");
+
+	// Assemble the line first, so it is written in one piece
+	ostringstream line;
+	line << fixed << setprecision(3)
+		 << "{\"event\":\"" << event << "\",\"time\":" << (now - startTime)
+		 << ",\"search\":\"" << (map != NULL ? "dfs" : "bfs") << "\"";
+	if (map != NULL) {
+		line << ",\"maxDepth\":" << maxDepth;
+	}
+	else {
+		line << ",\"depth\":" << depth << ",\"length\":" << length;
+		// At a depth event, the layer that is being written is still empty
+		if ((queue != NULL) && !depthEvent)
+			line << ",\"found\":" << queue->writeLength();
+	}
+	line << ",\"nodes\":" << n << ",\"rate\":" << rate << ",\"rss_kb\":" << rss();
+
+	// Project the size of the next layer by the growth factor between the last two layers
+	double growth = (prevLength > 0) ? (double)length / prevLength : 0;
+	double next = length * growth;
+
+	// Estimated time until the layer that is being written is complete: the configurations
+	// still to be found at the current rate
+	if ((queue != NULL) && (growth > 0) && (rate > 0)) {
+		double todo = depthEvent ? next : next - queue->writeLength();
+		line << ",\"eta_s\":" << ((todo > 0) ? todo / rate : 0);
+	}
+
+	if ((queue != NULL) && depthEvent) {
+		// At the next depth, the layer that is written now is appended to the temporary
+		// file and the queues have to hold the next and the following layer.
+		unsigned long ram, disk;
+		queue->usage(&ram, &disk);
+		double nextRam = ram + BFSQueue::entrySize() * (next * growth - length);
+		if (nextRam < ram)
+			nextRam = ram;
+		line << ",\"growth\":" << growth
+			 << ",\"ram_kb\":" << ram/1024 << ",\"disk_kb\":" << disk/1024
+			 << setprecision(0)
+			 << ",\"next_ram_kb\":" << nextRam/1024
+			 << ",\"next_disk_kb\":" << (disk + BFSQueue::entrySize() * next)/1024;
+	}
+	line << "}\n";
+	cerr << line.str() << flush;
+}
+
+// Main function of the reporting thread
+void * Progress::run(void *)
+{
+	double next = getTime() + interval;
+	while (running) {
+		usleep(100000);
+		if (getTime() >= next) {
+			pthread_mutex_lock(&mutex);
+			if ((queue != NULL) || (map != NULL))
+				report("progress");
+			pthread_mutex_unlock(&mutex);
+			next += interval;
+		}
+	}
+	return NULL;
+}
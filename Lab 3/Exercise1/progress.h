@@ -0,0 +1,88 @@
+using namespace std;
+
+class BFSQueue;
+class DFSDepthMap;
+
+/**
+ * This class (with only static attributes and methods) reports the progress of long running
+ * searches. If the environment variable SOKOBAN_PROGRESS is set to an interval in seconds,
+ * - a background thread prints a line with the current search rate and memory usage to stderr
+ *   after each interval, and
+ * - the breadth first search prints an additional line after each tree depth with the growth
+ *   factor between the layers and the projected RAM and disk usage for the next depth.
+ * In the breadth first search, 'eta_s' is the estimated time in seconds until the current
+ * layer is expanded, i.e., the projected size of the next layer divided by the current rate.
+ * All lines are JSON objects. The search loops themselves are not instrumented: the background
+ * thread only samples counters which are maintained by BFSQueue and DFSDepthMap anyway.
+ * If SOKOBAN_PROGRESS is not set, nothing is printed.
+ */
+class Progress
+{
+ public:
+	/**
+	 * Start the reporting thread, if SOKOBAN_PROGRESS is set.
+	 */
+	static void start();
+
+	/**
+	 * Stop the reporting thread.
+	 */
+	static void stop();
+
+	/**
+	 * The current search is finished. Must be called before the observed queue or map is
+	 * deleted; the reporting thread keeps running for the next search.
+	 */
+	static void done();
+
+	/**
+	 * Breadth first search: the layer with 'length' configurations of depth 'depth-1' is
+	 * going to be examined. The successors are entered into 'queue'.
+	 */
+	static void bfsDepth(unsigned int depth, unsigned int length, BFSQueue * queue);
+
+	/**
+	 * Depth first search: the search up to depth 'maxDepth' starts, using the mapping 'map'.
+	 */
+	static void dfsStart(DFSDepthMap * map, unsigned int maxDepth);
+
+	/**
+	 * Depth first search: a solution with 'length' pushes has been found.
+	 */
+	static void dfsSolution(unsigned int length);
+
+ private:
+	// Report interval in seconds (0: reporting is disabled)
+	static double interval;
+
+	// Start time of the search, time and number of configurations of the last report
+	static double startTime;
+	static double lastTime;
+	static unsigned long lastNodes;
+
+	// Observed data structures (only one of them is used)
+	static BFSQueue * queue;
+	static DFSDepthMap * map;
+
+	// Breadth first search: current depth, length of the current and of the previous layer,
+	// and the number of configurations of all layers that have been completed
+	static unsigned int depth;
+	static unsigned long length;
+	static unsigned long prevLength;
+	static unsigned long doneNodes;
+
+	// Depth first search: maximum depth, i.e., length of the best solution found so far
+	static unsigned int maxDepth;
+
+	// Returns the number of configurations found so far
+	static unsigned long nodes();
+
+	// Returns the resident set size of the process in KBytes
+	static unsigned long rss();
+
+	// Print one line of the report. 'event' is the name of the event.
+	static void report(const char * event);
+
+	// Main function of the reporting thread
+	static void * run(void * arg);
+};
@@ -0,0 +1,284 @@
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <string>
+#include <iostream>
+#include <fstream>
+
+#include "playfield.h"
+#include "pushtables.h"
+
+using namespace std;
+
+/**
+ * This class (with only static attributes and methods) contains tables that are derived from
+ * the playing field alone, i.e., they do not depend on the positions of the boxes.
+ * See pushtables.h for a description of the tables and the sidecar file.
+ */
+
+
+const unsigned short * PushTables::dist = NULL;
+const unsigned char * PushTables::flags = NULL;
+unsigned int PushTables::nGoals = 0;
+unsigned long PushTables::hash = 0;
+char * PushTables::owned = NULL;
+char * PushTables::mapped = NULL;
+unsigned long PushTables::mappedLength = 0;
+
+/*
+ * Header of a record in the sidecar file. It is followed by the distance matrix
+ * (nPos*nBox unsigned shorts) and the flags (nFields bytes), padded to a multiple of 8 bytes.
+ */
+struct TablesHeader {
+	char magic[4];          // "SOKT"
+	unsigned int version;   // Format version
+	unsigned long hash;     // Hash value of the playing field
+	unsigned int nFields;   // Dimensions of the playing field, for verification
+	unsigned int nPos;
+	unsigned int nBox;
+	unsigned int pad;
+	unsigned long length;   // Length of the record including this header
+};
+
+static const unsigned int VERSION = 2;
+
+// Length of a record with the tables for the current playing field
+static unsigned long recordLength()
+{
+	unsigned long len = sizeof(TablesHeader)
+		+ Playfield::nPos * Playfield::nBox * sizeof(unsigned short) + Playfield::nFields;
+	return (len + 7) & ~7UL;
+}
+
+// ==================================================================
+
+/**
+ * Compute the tables for the current playing field (see Playfield), or load them from
+ * the sidecar file of 'fname'. If 'fname' is NULL, the tables are not cached.
+ */
+void PushTables::init(const char * fname)
+{
+	release();
+	nGoals = Playfield::nBox;
+	hash = hashPlayfield();
+
+	if (fname == NULL) {
+		compute();
+		return;
+	}
+	string cname = string(fname) + ".tables";
+	if (!load(cname.c_str())) {
+		compute();
+		store(cname.c_str());
+	}
+}
+
+// Release the tables of the previous level
+void PushTables::release()
+{
+	delete[] owned;
+	owned = NULL;
+	if (mapped != NULL)
+		munmap(mapped, mappedLength);
+	mapped = NULL;
+	mappedLength = 0;
+	dist = NULL;
+	flags = NULL;
+}
+
+// Compute the hash value of the playing field (64 bit FNV-1a over the topology and the
+// positions of the targets)
+unsigned long PushTables::hashPlayfield()
+{
+	unsigned long h = 14695981039346656037UL;
+	unsigned int header[3] = { Playfield::nFields, Playfield::nPos, Playfield::nBox };
+	const unsigned char * p = (const unsigned char *)header;
+	for (unsigned int i=0; i<sizeof(header); i++)
+		h = (h ^ p[i]) * 1099511628211UL;
+	for (unsigned int dir=0; dir<4; dir++) {
+		p = (const unsigned char *)Playfield::neighbor[dir];
+		for (unsigned int i=0; i<Playfield::nFields*sizeof(unsigned int); i++)
+			h = (h ^ p[i]) * 1099511628211UL;
+	}
+	p = (const unsigned char *)Playfield::goalPos;
+	for (unsigned int i=0; i<Playfield::nBox*sizeof(unsigned int); i++)
+		h = (h ^ p[i]) * 1099511628211UL;
+	return h;
+}
+
+// Search the record for the current playing field in the sidecar file 'cname'.
+bool PushTables::load(const char * cname)
+{
+	int fd = open(cname, O_RDONLY);
+	if (fd < 0)
+		return false;
+	struct stat st;
+	if ((fstat(fd, &st) != 0) || (st.st_size < (off_t)sizeof(TablesHeader))) {
+		close(fd);
+		return false;
+	}
+	char * m = (char *)mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (m == MAP_FAILED)
+		return false;
+
+	// Walk through the records until we find a matching one
+	unsigned long off = 0;
+	while (off + sizeof(TablesHeader) <= (unsigned long)st.st_size) {
+		const TablesHeader * h = (const TablesHeader *)(m + off);
+		if ((memcmp(h->magic, "SOKT", 4) != 0) || (h->length < sizeof(TablesHeader))
+			|| (off + h->length > (unsigned long)st.st_size))
+			break; // corrupt file: ignore the rest
+		if ((h->version == VERSION) && (h->hash == hash)
+			&& (h->nFields == Playfield::nFields) && (h->nPos == Playfield::nPos)
+			&& (h->nBox == Playfield::nBox) && (h->length == recordLength())) {
+			mapped = m;
+			mappedLength = st.st_size;
+			dist = (const unsigned short *)(m + off + sizeof(TablesHeader));
+			flags = (const unsigned char *)(dist + Playfield::nPos * Playfield::nBox);
+			return true;
+		}
+		off += h->length;
+	}
+	munmap(m, st.st_size);
+	return false;
+}
+
+// Append the record for the current playing field to the sidecar file 'cname'
+void PushTables::store(const char * cname)
+{
+	// The cache is only an optimization. If it can not be written, we just recompute
+	// the tables next time.
+	ofstream file(cname, ios::out|ios::app|ios::binary);
+	if (file)
+		file.write(owned, recordLength());
+}
+
+// Compute all tables and store them in 'owned'
+void PushTables::compute()
+{
+	unsigned int nPos = Playfield::nPos;
+	unsigned int nFields = Playfield::nFields;
+
+	owned = new char[recordLength()]();
+	TablesHeader * h = (TablesHeader *)owned;
+	memcpy(h->magic, "SOKT", 4);
+	h->version = VERSION;
+	h->hash = hash;
+	h->nFields = nFields;
+	h->nPos = nPos;
+	h->nBox = nGoals;
+	h->length = recordLength();
+	unsigned short * d = (unsigned short *)(owned + sizeof(TablesHeader));
+	unsigned char * fl = (unsigned char *)(d + nPos * nGoals);
+
+	// (1) Push distances: one backward search per target. The box may only be placed on
+	// fields that are not dead-ends. The targets are independent of each other.
+	#pragma omp parallel for schedule(dynamic)
+	for (unsigned int g=0; g<nGoals; g++) {
+		unsigned short gd[nFields];
+		pull(Playfield::neighbor, nFields, nPos, &Playfield::goalPos[g], 1, gd);
+		for (unsigned int p=0; p<nPos; p++)
+			d[p*nGoals + g] = gd[p];
+	}
+
+	// (2) Goal reachability and tunnels
+	#pragma omp parallel for
+	for (unsigned int p=0; p<nFields; p++) {
+		bool reachable = false;
+		if (p < nPos) {
+			for (unsigned int g=0; g<nGoals; g++)
+				reachable = reachable || (d[p*nGoals + g] != INF);
+		}
+		if (!reachable)
+			fl[p] |= UNREACHABLE;
+		// Horizontal tunnel: walls above and below; vertical tunnel: walls left and right
+		bool horiz = !Playfield::isValid(Playfield::neighbor[1][p])
+			&& !Playfield::isValid(Playfield::neighbor[3][p]);
+		bool vert = !Playfield::isValid(Playfield::neighbor[0][p])
+			&& !Playfield::isValid(Playfield::neighbor[2][p]);
+		if (horiz || vert)
+			fl[p] |= TUNNEL;
+	}
+
+	// (3) Articulation fields (sequential, the graph is small)
+	unsigned int * disc = new unsigned int[nFields]();
+	unsigned int * low = new unsigned int[nFields];
+	unsigned int num = 0;
+	for (unsigned int p=0; p<nFields; p++) {
+		if (disc[p] == 0)
+			articulation(p, Playfield::NONE, &num, disc, low, fl);
+	}
+	delete[] disc;
+	delete[] low;
+
+	dist = d;
+	flags = fl;
+}
+
+/**
+ * Backward breadth first search (the player pulls a box away from the 'nSources' fields
+ * 'sources'): returns in 'dist' for each of the 'n' fields the minimum number of pushes
+ * that move a box from this field onto one of the sources, or INF. The topology is given
+ * by 'neighbor' (as in Playfield). A box may only be placed on the fields 0...nBoxFields-1.
+ */
+void PushTables::pull(unsigned int * const neighbor[4], unsigned int n, unsigned int nBoxFields,
+					  const unsigned int sources[], unsigned int nSources, unsigned short dist[])
+{
+	unsigned int queue[n];
+	unsigned int in = 0, out = 0;
+	for (unsigned int p=0; p<n; p++)
+		dist[p] = INF;
+	for (unsigned int s=0; s<nSources; s++) {
+		if (dist[sources[s]] == INF) {
+			dist[sources[s]] = 0;
+			queue[in++] = sources[s];
+		}
+	}
+	// A box on field 'q' can be pushed in direction 'dir' onto field 'r', if the player
+	// can stand on the opposite side of 'q'.
+	while (out < in) {
+		unsigned int r = queue[out++];
+		for (unsigned int dir=0; dir<4; dir++) {
+			unsigned int q = neighbor[dir^2][r];
+			if (!Playfield::isValid(q) || (q >= nBoxFields))
+				continue;
+			unsigned int player = neighbor[dir^2][q];
+			if (Playfield::isValid(player) && (dist[q] == INF)) {
+				dist[q] = dist[r] + 1;
+				queue[in++] = q;
+			}
+		}
+	}
+}
+
+// Compute the articulation fields using Tarjan's algorithm: depth first search from
+// field 'pos', reached from 'parent'. '*num' counts the discovered fields.
+void PushTables::articulation(unsigned int pos, unsigned int parent, unsigned int * num,
+							  unsigned int disc[], unsigned int low[], unsigned char fl[])
+{
+	unsigned int children = 0;
+	disc[pos] = low[pos] = ++*num;
+	for (unsigned int dir=0; dir<4; dir++) {
+		unsigned int n = Playfield::neighbor[dir][pos];
+		if (!Playfield::isValid(n) || (n == parent))
+			continue;
+		if (disc[n] == 0) {
+			children++;
+			articulation(n, pos, num, disc, low, fl);
+			if (low[n] < low[pos])
+				low[pos] = low[n];
+			if ((parent != Playfield::NONE) && (low[n] >= disc[pos]))
+				fl[pos] |= ARTICULATION;
+		}
+		else if (disc[n] < low[pos]) {
+			low[pos] = disc[n];
+		}
+	}
+	if ((parent == Playfield::NONE) && (children > 1))
+		fl[pos] |= ARTICULATION;
+}
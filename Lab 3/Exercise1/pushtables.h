@@ -0,0 +1,120 @@
+using namespace std;
+
+/**
+ * This class (with only static attributes and methods) contains tables that are derived from
+ * the playing field alone, i.e., they do not depend on the positions of the boxes:
+ *  - the push distance matrix: the minimum number of pushes needed to move a single box from
+ *    a field to a target, if there were no other boxes on the playing field,
+ *  - the goal reachability: can a box on a field reach any target at all?
+ *  - tunnel fields: fields whose neighbors on both sides of one axis are walls,
+ *  - articulation fields: fields which split the playing field into separate areas when
+ *    they are occupied by a box. A box on such a field creates a corral, i.e., an area the
+ *    player cannot enter any more.
+ * The tables are computed in parallel (one target per thread for the distances). Since they
+ * depend only on the level, they are cached in a binary sidecar file '<level-file>.tables'.
+ * Each level is stored as a record which is identified by a hash value of the playing field,
+ * so a single sidecar file can hold the tables for a whole collection of levels. Later runs
+ * map the sidecar file into memory and use the stored tables instead of recomputing them.
+ */
+class PushTables
+{
+ public:
+	/**
+	 * Special value in the distance matrix, if a target can not be reached.
+	 */
+	static const unsigned short INF = 0xffff;
+
+	/**
+	 * Compute the tables for the current playing field (see Playfield), or load them from
+	 * the sidecar file of 'fname'. If 'fname' is NULL, the tables are not cached.
+	 */
+	static void init(const char * fname);
+
+	/**
+	 * Minimum number of pushes that move a box from field 'pos' (0...nPos-1) onto the
+	 * target 'goal' (0...nBox-1), ignoring all other boxes, or INF.
+	 */
+	static inline unsigned short distance(unsigned int pos, unsigned int goal)
+	{
+		return dist[pos * nGoals + goal];
+	}
+
+	/**
+	 * Can a box on field 'pos' (0...nPos-1) be pushed onto any target?
+	 */
+	static inline bool canReachGoal(unsigned int pos)
+	{
+		return (flags[pos] & UNREACHABLE) == 0;
+	}
+
+	/**
+	 * Is field 'pos' part of a tunnel?
+	 */
+	static inline bool isTunnel(unsigned int pos)
+	{
+		return (flags[pos] & TUNNEL) != 0;
+	}
+
+	/**
+	 * Does a box on field 'pos' split the playing field into separate areas?
+	 */
+	static inline bool isArticulation(unsigned int pos)
+	{
+		return (flags[pos] & ARTICULATION) != 0;
+	}
+
+	/**
+	 * Backward breadth first search (the player pulls a box away from the 'nSources' fields
+	 * 'sources'): returns in 'dist' for each of the 'n' fields the minimum number of pushes
+	 * that move a box from this field onto one of the sources, or INF. The topology is given
+	 * by 'neighbor' (as in Playfield). A box may only be placed on the fields 0...nBoxFields-1.
+	 * This is also used by Playfield::initXSB() to determine the dead-end fields.
+	 */
+	static void pull(unsigned int * const neighbor[4], unsigned int n, unsigned int nBoxFields,
+					 const unsigned int sources[], unsigned int nSources, unsigned short dist[]);
+
+ private:
+	// Bits in the 'flags' array
+	static const unsigned char UNREACHABLE  = 1;
+	static const unsigned char TUNNEL       = 2;
+	static const unsigned char ARTICULATION = 4;
+
+	// Push distance matrix: dist[pos*nGoals + goal]
+	static const unsigned short * dist;
+
+	// Flags for each field of the playing field
+	static const unsigned char * flags;
+
+	// Number of targets (columns of the distance matrix)
+	static unsigned int nGoals;
+
+	// Hash value of the playing field, identifies the record in the sidecar file
+	static unsigned long hash;
+
+	// Memory allocated for the tables, if they have been computed (else NULL)
+	static char * owned;
+
+	// Sidecar file mapped into memory (else NULL) and its length
+	static char * mapped;
+	static unsigned long mappedLength;
+
+	// Release the tables of the previous level
+	static void release();
+
+	// Compute the hash value of the playing field
+	static unsigned long hashPlayfield();
+
+	// Search the record for the current playing field in the sidecar file 'cname'.
+	static bool load(const char * cname);
+
+	// Compute all tables and store them in 'owned'
+	static void compute();
+
+	// Append the record for the current playing field to the sidecar file 'cname'
+	static void store(const char * cname);
+
+	// Compute the articulation fields using Tarjan's algorithm: depth first search from
+	// field 'pos', reached from 'parent'. '*num' counts the discovered fields.
+	static void articulation(unsigned int pos, unsigned int parent, unsigned int * num,
+							 unsigned int disc[], unsigned int low[], unsigned char fl[]);
+};
@@ -4,12 +4,15 @@
 #include <string>
 #include <iostream>
 #include <fstream>
+#include <atomic>
 
 #include "converter.h"
 #include "config.h"
 #include "bfsqueue.h"
 #include "dfsstack.h"
 #include "dfsdepthmap.h"
+#include "progress.h"
+#include "xsbreader.h"
 
 using namespace std;
 
@@ -96,21 +99,35 @@ static void doBreadthFirstSearch(Config * conf)
 	
 	// Pass through all layers of the tree with increasing depth until there are no
 	// configurations with this depth any more.
-	bool solutionFound = false;
+	// As soon as one thread finds a solution, all threads stop working on the current layer:
+	// each thread checks the flag 'solutionFound' before it examines the next configuration.
+	// The solution configuration and the index of its predecessor are stored, so that the
+	// path can be printed outside of the parallel region. The flag is atomic, since it is
+	// read while another thread may set it. Relaxed loads suffice for skipping work; the
+	// solution itself is written inside the critical section and read after the implicit
+	// barrier of the loop.
+	atomic<bool> solutionFound(false);
+	unsigned long solutionConf = Config::NONE; // Solution configuration
+	unsigned int solutionPred = 0;             // Index of its predecessor in the read queue
 	while (length > 0) {
 		// Print the progress
 		cerr << "depth " << depth << ": " << length << "\n" << flush;
+		Progress::bfsDepth(depth, length, queue);
 		
-		// Consider all configurations of depth 'depth-1'.
-		#pragma omp parallel for private(lastBox)
+		// Consider all configurations of depth 'depth-1'. The loop is split into small
+		// chunks, so that the remaining chunks are skipped quickly after a solution
+		// has been found.
+		#pragma omp parallel for private(lastBox) schedule(dynamic, 64)
 		for (unsigned int i=0; i<length; i++) {
+			if (solutionFound.load(memory_order_relaxed))
+				continue;
 			// Read the configuration from the queue
 			Config newConf(queue->get(i, &lastBox));
 			// Consider all boxes, starting with the box that was moved last
-			for (unsigned int b=0; b<nBoxes; b++) {
+			for (unsigned int b=0; b<nBoxes && !solutionFound.load(memory_order_relaxed); b++) {
 				unsigned int box = (b + lastBox) % nBoxes;
 				// Consider all directions of movement
-				for (unsigned int dir=0; dir<4 && !solutionFound; dir++) {
+				for (unsigned int dir=0; dir<4 && !solutionFound.load(memory_order_relaxed); dir++) {
 					unsigned int newBox;
 					// Determine the configuration that results from moving box
 					// 'box' in direction 'dir'.
@@ -118,23 +135,33 @@ static void doBreadthFirstSearch(Config * conf)
 					// If the move is valid, check whether the resuling configuration has
 					// been examined before. If not, add it to the queue
 					if ((c != Config::NONE)) {
-						bool configAdded = false;
+						// If we found a solution: remember it and terminate the search.
+						// Only the first solution is recorded.
 						#pragma omp critical
-						configAdded = queue->lookup_and_add(c, i, newBox);
-						// If we found a solution: print it and terminate the search
-						if (configAdded && Config::isSolutionConf(c)) {
-							solutionFound = true;
-							unsigned int len;
-							unsigned long * path = queue->getPath(c, i, &len);
-							printPath(path, len);
-							delete[] path;
-							queue->statistics();
+						if (queue->lookup_and_add(c, i, newBox) && Config::isSolutionConf(c)
+							&& !solutionFound.load(memory_order_relaxed)) {
+							solutionConf = c;
+							solutionPred = i;
+							solutionFound.store(true, memory_order_release);
 						}
 					}
 				}
 			}
 		}
 
+		// Print the solution path. This must be done before the queue is advanced, since
+		// the path is determined relative to the current read queue.
+		if (solutionFound.load()) {
+			unsigned int len;
+			unsigned long * path = queue->getPath(solutionConf, solutionPred, &len);
+			printPath(path, len);
+			delete[] path;
+			queue->statistics();
+			Progress::done();
+			delete queue;
+			return;
+		}
+
 		// Advance the queue for the next tree depth
 		depth++;
 		queue->pushDepth();
@@ -145,6 +172,8 @@ static void doBreadthFirstSearch(Config * conf)
 	// If the loop exits normally, there is no solution
 	cout << "No solution found!\n";
 	queue->statistics();
+	Progress::done();
+	delete queue;
 }
 
 /**
@@ -179,6 +208,7 @@ static void recDepthFirstSearch(Config * conf, unsigned int lastBox,
 		delete[] path;
 		path = stack->getPath(&path_len);	
 		cout << "Found solution: " << (path_len-1) << " pushes\n";
+		Progress::dfsSolution(path_len-1);
 		stack->pop();
 		return;
 	}
@@ -235,36 +265,30 @@ static void doDepthFirstSearch(Config * conf, unsigned int maxDepth)
 	DFSDepthMap map(Config::getNumConfigs(), maxDepth);
 	map.lookup_and_set(conf->getConfig(), 1);
 	path_len = maxDepth;
+	Progress::dfsStart(&map, maxDepth);
 	#pragma omp parallel
 	#pragma omp single nowait
 	recDepthFirstSearch(conf, 0, &stack, &map);
 
+	Progress::done();
 	map.statistics(path_len);
 
-	printPath(path, path_len);
+	// If no solution was found within the maximum depth, 'path' is still NULL
+	printPath(path, path != NULL ? path_len : 0);
 	delete[] path;
+	path = NULL;
 }
 
 /**
- * Main program. Invocation:
- *    sokoban <level-file> [<max-depth>]
- * If 'max-depth' is give, a depth first search up to a maximum depth of 'max-depth'
- * is performed, otherwise a breadth first search.
+ * Solve the level with the starting configuration 'conf' and print the run time. If
+ * 'maxDepth' is not 0, a depth first search up to this depth is performed, otherwise
+ * a breadth first search.
  */
-int main(int argc, char **argv)
+static void solve(Config * conf, unsigned int maxDepth)
 {
-	if ((argc < 2) || (argc > 3)) {
-		cerr << "Usage: sokoban <level-file> [<max-depth>]\n";
-		exit(1);
-	}
-
-	// Initialize the configuration with the starting configuration (level) from the file
-	Config * conf = Config::init(argv[1]);
-
 	double ta = getTime();
-	if (argc > 2) {
+	if (maxDepth > 0) {
 		// depth first search
-		unsigned int maxDepth = atoi(argv[2]);
 		doDepthFirstSearch(conf, maxDepth+1);
 	}
 	else {
@@ -276,6 +300,66 @@ int main(int argc, char **argv)
 	// Print the run time
 	cout << "\n";
 	cout << "Total time (s): " << (te-ta) << "\n";
+}
+
+/**
+ * Is the file 'fname' a level collection in XSB format (file extension .xsb or .sok)?
+ */
+static bool isCollection(const char * fname)
+{
+	string name(fname);
+	unsigned int len = name.length();
+	return (len > 4) && ((name.compare(len-4, 4, ".xsb") == 0)
+						 || (name.compare(len-4, 4, ".sok") == 0));
+}
+
+/**
+ * Main program. Invocation:
+ *    sokoban <level-file> [<max-depth>]
+ * If 'max-depth' is give, a depth first search up to a maximum depth of 'max-depth'
+ * is performed, otherwise a breadth first search.
+ * If the level file has the extension .xsb or .sok, it is read as a collection of levels
+ * in the standard XSB format, and all levels are solved one after the other.
+ * Set the environment variable SOKOBAN_PROGRESS to an interval in seconds to get
+ * periodic progress reports on stderr.
+ */
+int main(int argc, char **argv)
+{
+	if ((argc < 2) || (argc > 3)) {
+		cerr << "Usage: sokoban <level-file> [<max-depth>]\n";
+		exit(1);
+	}
+	unsigned int maxDepth = (argc > 2) ? atoi(argv[2]) : 0;
+
+	if (isCollection(argv[1])) {
+		// Read the collection level by level, so that the memory usage does not depend
+		// on the size of the collection.
+		XSBReader reader(argv[1]);
+		vector<string> level;
+		string title;
+		Progress::start();
+		while (reader.next(level, title)) {
+			cerr << "\n" << title << "\n";
+			cout << "\n" << title << "\n";
+			Config * conf = Config::initXSB(argv[1], level);
+			if (conf == NULL) {
+				cerr << "Skipping level\n";
+				continue;
+			}
+			solve(conf, maxDepth);
+			delete conf;
+		}
+		Progress::stop();
+		return 0;
+	}
+
+	// Initialize the configuration with the starting configuration (level) from the file
+	Config * conf = Config::init(argv[1]);
+
+	// Start the progress reports (only if requested, see progress.h)
+	Progress::start();
+	solve(conf, maxDepth);
+	Progress::stop();
 
 	return 0;
 }
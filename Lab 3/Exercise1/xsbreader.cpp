@@ -0,0 +1,139 @@
+#include <stdlib.h>
+#include <ctype.h>
+
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+
+#include "xsbreader.h"
+
+using namespace std;
+
+/**
+ * Reader for level collections in the standard XSB format. The file is read incrementally:
+ * only the rows of the current level are kept in memory.
+ */
+
+
+/**
+ * Constructor: Opens the collection file 'fname'.
+ */
+XSBReader::XSBReader(const char * fname)
+	: file(fname)
+{
+	if (!file) {
+		cerr << "Error opening '" << fname << "'\n";
+		exit(1);
+	}
+	count = 0;
+	hasPending = false;
+}
+
+/**
+ * Reads the next level into 'level' (one string per row). In 'title', a description of
+ * the level is returned. The return value is false, if there are no more levels.
+ */
+bool XSBReader::next(vector<string> & level, string & title)
+{
+	string line, key, value, name;
+	bool more;
+	level.clear();
+	while ((more = readLine(line))) {
+		if (isLevelLine(line)) {
+			level.push_back(line);
+		}
+		else if (!level.empty()) {
+			// The first line after the rows terminates the level
+			break;
+		}
+		else if (line.length() > 0) {
+			// Remember the comment in front of the level
+			comment = line;
+		}
+	}
+	if (level.empty())
+		return false;
+
+	// The metadata lines after the rows belong to this level. The first other line
+	// belongs to the next one.
+	while (more && isMetadata(line, key, value)) {
+		if (key == "Title") {
+			name = value;
+		}
+		else if ((key == "Comment") && value.empty()) {
+			// A block of comment lines up to 'Comment-End:'. With a value, 'Comment:'
+			// is a single line.
+			while ((more = readLine(line))
+				   && !(isMetadata(line, key, value) && (key == "Comment-End")))
+				;
+		}
+		more = readLine(line);
+	}
+	if (more) {
+		pending = line;
+		hasPending = true;
+	}
+
+	count++;
+	ostringstream t;
+	t << "Level " << count;
+	if (!name.empty())
+		t << " (" << name << ")";
+	else if (!comment.empty())
+		t << " (" << comment << ")";
+	title = t.str();
+	comment.clear();
+	return true;
+}
+
+// Read the next line without trailing white space. Returns false at the end of the file.
+bool XSBReader::readLine(string & line)
+{
+	if (hasPending) {
+		line = pending;
+		hasPending = false;
+		return true;
+	}
+	if (!getline(file, line))
+		return false;
+	// Remove trailing white space (and the CR of DOS line endings)
+	unsigned int len = line.length();
+	while ((len > 0) && ((line[len-1] == '\r') || (line[len-1] == ' ')
+						 || (line[len-1] == '\t')))
+		len--;
+	line.resize(len);
+	return true;
+}
+
+// Is 'line' a row of a level?
+bool XSBReader::isLevelLine(const string & line)
+{
+	bool wall = false;
+	for (unsigned int i=0; i<line.length(); i++) {
+		char c = line[i];
+		if (c == '#')
+			wall = true;
+		else if ((c != '@') && (c != '+') && (c != '$') && (c != '*') && (c != '.')
+				 && (c != ' ') && (c != '-') && (c != '_'))
+			return false;
+	}
+	return wall;
+}
+
+// Is 'line' a metadata line 'Key: value'? If so, the key is returned in 'key' and the
+// value in 'value'.
+bool XSBReader::isMetadata(const string & line, string & key, string & value)
+{
+	unsigned int i = 0;
+	while ((i < line.length()) && (isalpha(line[i]) || (line[i] == '-')))
+		i++;
+	if ((i == 0) || (i >= line.length()) || (line[i] != ':'))
+		return false;
+	key = line.substr(0, i);
+	i++;
+	while ((i < line.length()) && ((line[i] == ' ') || (line[i] == '\t')))
+		i++;
+	value = line.substr(i);
+	return true;
+}
@@ -0,0 +1,62 @@
+#include <vector>
+
+using namespace std;
+
+/**
+ * Reader for level collections in the standard XSB format, e.g.
+ *
+ *     ; 1
+ *     #####
+ *     #@$.#
+ *     #####
+ *     Title: First level
+ *     Author: Someone
+ *
+ * with the symbols '#' (wall), '@' (player), '+' (player on target), '$' (box),
+ * '*' (box on target), '.' (target) and ' ', '-' or '_' (floor). Levels are separated by
+ * lines which are empty or contain other characters (comments, ...). Lines of the form
+ * 'Key: value' directly after the rows are metadata of the level: the title is used as
+ * its name, all other keys (Author, a one-line 'Comment: text', a block from 'Comment:'
+ * up to 'Comment-End:', ...) are ignored.
+ * The file is read incrementally: only the rows of the current level are kept in memory,
+ * so arbitrarily large collections can be processed. The rows are converted to the internal
+ * representation by Playfield::initXSB().
+ */
+class XSBReader
+{
+ private:
+	// The collection file
+	ifstream file;
+
+	// Number of levels read so far
+	unsigned int count;
+
+	// Last comment line before the current level
+	string comment;
+
+	// Line that has already been read, but belongs to the next level (if 'hasPending')
+	string pending;
+	bool hasPending;
+
+	// Read the next line without trailing white space. Returns false at the end of the file.
+	bool readLine(string & line);
+
+	// Is 'line' a row of a level?
+	static bool isLevelLine(const string & line);
+
+	// Is 'line' a metadata line 'Key: value'? If so, the key is returned in 'key' and the
+	// value in 'value'.
+	static bool isMetadata(const string & line, string & key, string & value);
+
+ public:
+	/**
+	 * Constructor: Opens the collection file 'fname'.
+	 */
+	XSBReader(const char * fname);
+
+	/**
+	 * Reads the next level into 'level' (one string per row). In 'title', a description of
+	 * the level is returned. The return value is false, if there are no more levels.
+	 */
+	bool next(vector<string> & level, string & title);
+};
@@ -0,0 +1,99 @@
+/*************************************************************************
+** Block decomposition of the n*n matrix on a 2D process grid
+**
+** The processes are arranged in a dims[0] x dims[1] grid (a Cartesian
+** communicator), and each process owns a block of rows and columns of
+** the matrix, including the parts of the global boundary in its block.
+** With a 1D decomposition (dims[1] = 1), each process owns whole rows
+** and exchanges 2 rows of n elements per iteration, independent of the
+** number of processes. With a 2D decomposition, a block only has
+** about 4*n/sqrt(p) neighbor elements.
+**
+** Environment variable:
+**   DECOMP   "2d" (default): MPI_Dims_create() chooses the process grid
+**            "1d": blocks of rows, as in the original version
+** Solvers which need blocks of rows can request them with 'rowsOnly'.
+**
+** Author:   RW
+**
+*************************************************************************/
+
+#ifndef DECOMP_H
+#define DECOMP_H
+
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+
+/*
+** Number of elements of process p (of np) in a dimension with n elements,
+** and the index of its first element. The last n % np processes get one
+** element more.
+*/
+inline int blockSize(int n, int p, int np)
+{
+	return (n + p) / np;
+}
+
+inline int blockStart(int n, int p, int np)
+{
+	int r = p - (np - n % np);
+	return (n / np) * p + ((r > 0) ? r : 0);
+}
+
+struct Block {
+	MPI_Comm comm;       /* Cartesian communicator */
+	int rank;            /* Own rank in 'comm' */
+	int dims[2];         /* Number of processes per dimension */
+	int coords[2];       /* Own position in the process grid */
+	int n;               /* Size of the matrix */
+	int row0, col0;      /* Global index of the first own row/column */
+	int rows, cols;      /* Number of own rows/columns */
+	int up, down;        /* Neighbors (MPI_PROC_NULL at the boundary) */
+	int left, right;
+
+	/*
+	** Is the element a[i][j] (global indices) in this block?
+	*/
+	bool owns(int i, int j) const
+	{
+		return (i >= row0) && (i < row0 + rows) && (j >= col0) && (j < col0 + cols);
+	}
+};
+
+/*
+** Create the process grid and determine the own block. With 'rowsOnly',
+** the blocks always consist of whole rows.
+*/
+inline Block createBlock(int n, bool rowsOnly = false)
+{
+	Block b;
+	int nprocs, periods[2] = { 0, 0 };
+
+	MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+	b.dims[0] = b.dims[1] = 0;
+	const char *env = getenv("DECOMP");
+	if (rowsOnly || ((env != NULL) && (strcmp(env, "1d") == 0)))
+		b.dims[1] = 1;
+	MPI_Dims_create(nprocs, 2, b.dims);
+	if ((b.dims[0] > n) || (b.dims[1] > n)) {
+		std::cerr << "Error: too many processes for the matrix size!\n";
+		MPI_Abort(MPI_COMM_WORLD, 1);
+	}
+
+	MPI_Cart_create(MPI_COMM_WORLD, 2, b.dims, periods, 0, &b.comm);
+	MPI_Comm_rank(b.comm, &b.rank);
+	MPI_Cart_coords(b.comm, b.rank, 2, b.coords);
+	MPI_Cart_shift(b.comm, 0, 1, &b.up, &b.down);
+	MPI_Cart_shift(b.comm, 1, 1, &b.left, &b.right);
+
+	b.n = n;
+	b.row0 = blockStart(n, b.coords[0], b.dims[0]);
+	b.rows = blockSize(n, b.coords[0], b.dims[0]);
+	b.col0 = blockStart(n, b.coords[1], b.dims[1]);
+	b.cols = blockSize(n, b.coords[1], b.dims[1]);
+	return b;
+}
+
+#endif
@@ -1,8 +1,28 @@
 /*************************************************************************
 ** Iterative solver: Jacobi method
 **
+** Each process owns a block of the matrix (see decomp.h), surrounded by
+** a halo of ghost cells, which hold copies of the neighbors' boundary
+** rows and columns. The columns are sent with a derived datatype
+** (MPI_Type_vector), so they need not be copied into a buffer.
+**
+** In each iteration, the exchange of the ghost cells is started with
+** non-blocking communication, and the inner part of the block, which
+** does not need the ghost cells, is computed while the messages are in
+** flight. Only then, the first and last row and column of the block are
+** computed.
+**
+** The time spent waiting for the ghost cells and in the global reduction
+** of the convergence check is reported separately (maximum over all
+** processes).
+**
+** Compiled with -fopenmp (heat-hybrid), the loops over the rows of the
+** block are executed by OpenMP threads. All MPI calls are made by the
+** master thread outside of the parallel regions (MPI_THREAD_FUNNELED);
+** the messages are in flight while the threads compute the inner part.
+**
 ** Author:   RW
-** 
+**
 *************************************************************************/
 
 #include <iostream>
@@ -10,6 +30,11 @@
 #include <math.h>
 #include <mpi.h>
 
+#include "grid2d.h"
+#include "decomp.h"
+#include "checkinterval.h"
+#include "instrument.h"
+
 using namespace std;
 
 
@@ -20,75 +45,189 @@ using namespace std;
 extern double eps;
 
 
-/* Auxiliary Functions *************************************************** */
+/* Jacobi iteration ***************************************************** */
+
+/*
+** Jacobi update of the elements j0 .. j1-1 of row i of 'a' into 'b'.
+** If 'check' is true, the maximum change of the elements is returned,
+** otherwise 0.
+*/
+static inline double update_row(Grid2D<double> &a, Grid2D<double> &b, int i,
+								 int j0, int j1, bool check)
+{
+	int j;
+	double h, diff = 0;
+	const double *up = a[i-1], *mid = a[i], *down = a[i+1];
+	double *dst = b[i];
 
-extern double ** New_Matrix(int m, int n);
-extern void Delete_Matrix(double **matrix);
+	if (check) {
+		for (j=j0; j<j1; j++) {
+			dst[j] = 0.25 * (mid[j-1] + up[j] + down[j] + mid[j+1]);
+			/* Determine the maximum change of the matrix elements */
+			h = fabs(mid[j] - dst[j]);
+			if (h > diff)
+				diff = h;
+		}
+	}
+	else {
+		for (j=j0; j<j1; j++)
+			dst[j] = 0.25 * (mid[j-1] + up[j] + down[j] + mid[j+1]);
+	}
+	return diff;
+}
 
+/*
+** Start the exchange of the ghost cells of 'a'. 'req' must have room
+** for 8 requests. At the boundary of the process grid, the neighbor is
+** MPI_PROC_NULL, so nothing is transferred.
+*/
+static void start_exchange(Grid2D<double> &a, const Block &blk,
+						   MPI_Datatype column, MPI_Request *req)
+{
+	int rows = blk.rows, cols = blk.cols;
 
-/* Jacobi iteration ***************************************************** */
+	MPI_Irecv(a[-1], cols, MPI_DOUBLE, blk.up, 1, blk.comm, &req[0]);
+	MPI_Irecv(a[rows], cols, MPI_DOUBLE, blk.down, 0, blk.comm, &req[1]);
+	MPI_Irecv(&a[0][-1], 1, column, blk.left, 3, blk.comm, &req[2]);
+	MPI_Irecv(&a[0][cols], 1, column, blk.right, 2, blk.comm, &req[3]);
+	MPI_Isend(a[0], cols, MPI_DOUBLE, blk.up, 0, blk.comm, &req[4]);
+	MPI_Isend(a[rows-1], cols, MPI_DOUBLE, blk.down, 1, blk.comm, &req[5]);
+	MPI_Isend(&a[0][0], 1, column, blk.left, 2, blk.comm, &req[6]);
+	MPI_Isend(&a[0][cols-1], 1, column, blk.right, 3, blk.comm, &req[7]);
+}
 
 /*
-** Execute Jacobi iteration on the m*n matrix 'a'.
+** Execute Jacobi iteration on the block 'a' (with a halo of 1) of the
+** n*n matrix.
 */
-int solver(double **a, int m, int n)
+int solver(Grid2D<double> &a, const Block &blk)
 {
 	int i,j;
-	double h;
 	double diff, gdiff;    /* Maximum change since the last iteration */
 	int k = 0;      /* Counts iterations (for statistics only ...) */
-	double **b = New_Matrix(m,n);  /* Auxiliary matrix for result */
-	MPI_Status status;
-	int nprocs, myrank;
-	MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
-	MPI_Comm_rank(MPI_COMM_WORLD, &myrank);
+	int rows = blk.rows, cols = blk.cols;
+	Grid2D<double> b(rows, cols, 1);  /* Auxiliary matrix for result */
+	CheckInterval ci;       /* When to compute 'diff' (see checkinterval.h) */
+	bool done;
+	MPI_Request req[8];
+	MPI_Datatype column;
+	double tstart, twait = 0, treduce = 0;
 
-	if (b == NULL) {
+	if (b.data() == NULL) {
 		cerr << "Jacobi: Can't allocate matrix\n";
 		exit(1);
 	}
-	
+
+	/*
+	** Range of the elements to be updated (the global boundary is fixed),
+	** and of the inner part, which does not depend on the ghost cells.
+	*/
+	int ilo = (blk.row0 == 0) ? 1 : 0;
+	int ihi = (blk.row0 + rows == blk.n) ? rows - 1 : rows;
+	int jlo = (blk.col0 == 0) ? 1 : 0;
+	int jhi = (blk.col0 + cols == blk.n) ? cols - 1 : cols;
+	int ilo2 = (ilo > 1) ? ilo : 1, ihi2 = (ihi < rows - 1) ? ihi : rows - 1;
+	int jlo2 = (jlo > 1) ? jlo : 1, jhi2 = (jhi < cols - 1) ? jhi : cols - 1;
+
+	/* One column of the block (a and b have the same row stride) */
+	MPI_Type_vector(rows, 1, a.stride(), MPI_DOUBLE, &column);
+	MPI_Type_commit(&column);
+
+	/*
+	** The boundary is never changed, so it is copied into 'b' once.
+	** Afterwards, 'a' and 'b' just swap their roles in each iteration.
+	*/
+	PHASE_BEGIN(tcopy);
+	#pragma omp parallel for private(j)
+	for (i=-1; i<=rows; i++) {
+		for (j=-1; j<=cols; j++) {
+			b[i][j] = a[i][j];
+		}
+	}
+	PHASE_END(tcopy, PHASE_COPY);
+
 	/*
 	** Iterate until convergence is achieved. Here: until the maximum
-	** change of a matrix element is smaller or equal than 'eps'.
+	** change of a matrix element is smaller or equal than 'eps'. The
+	** change (and the global maximum) is only computed in some iterations
+	** (see checkinterval.h). All processes make the same decisions, since
+	** they are based on the global maximum.
 	*/
 	do {
+		bool check = ci.check(k+1);
+
+		PHASE_BEGIN(texch);
+		start_exchange(a, blk, column, req);
+		PHASE_END(texch, PHASE_COMM);
+
+		/*
+		** Inner part: it only depends on elements of the own block.
+		*/
+		PHASE_BEGIN(tinner);
 		diff = 0;
-		for (i=1; i<m-1; i++) {
-			for (j=1; j<n-1; j++) {
-				b[i][j] = 0.25 * (a[i][j-1] + a[i-1][j] + a[i+1][j] + a[i][j+1]);
-				/* Determine the maximum change of the matrix elements */
-				h = fabs(a[i][j] - b[i][j]);
-				if (h > diff)
-					diff = h;
-			}
+		#pragma omp parallel for reduction(max: diff)
+		for (i=ilo2; i<ihi2; i++) {
+			double h = update_row(a, b, i, jlo2, jhi2, check);
+			if (h > diff)
+				diff = h;
 		}
+
+		PHASE_END(tinner, PHASE_SWEEP);
+
+		PHASE_BEGIN(twaitall);
+		tstart = MPI_Wtime();
+		MPI_Waitall(8, req, MPI_STATUSES_IGNORE);
+		twait += MPI_Wtime() - tstart;
+		PHASE_END(twaitall, PHASE_COMM);
+
 		/*
-		** Copy intermediate result into matrix 'a'
+		** First and last row and column of the block
 		*/
-		for (i=1; i<m-1; i++) {
-			for (j=1; j<n-1; j++) {
-				a[i][j] = b[i][j];
+		PHASE_BEGIN(tedge);
+		#pragma omp parallel for reduction(max: diff)
+		for (i=ilo; i<ihi; i++) {
+			double h = 0, h2 = 0;
+			if ((i == 0) || (i == rows - 1))
+				h = update_row(a, b, i, jlo, jhi, check);
+			else {
+				if (jlo == 0)
+					h = update_row(a, b, i, 0, 1, check);
+				if (jhi == cols)
+					h2 = update_row(a, b, i, cols - 1, cols, check);
 			}
+			if (h2 > h)
+				h = h2;
+			if (h > diff)
+				diff = h;
 		}
+		PHASE_END(tedge, PHASE_SWEEP);
+
+		/*
+		** The result of this iteration is the input of the next one
+		** (only the memory blocks are exchanged)
+		*/
+		a.swap(b);
 		k++;
-		// ghost cells fill up steps
-		// Step 1: Send downwards, recieve from above
-		if (myrank != nprocs-1)
-			MPI_Send(a[m-2], n, MPI_DOUBLE, myrank+1, 0, MPI_COMM_WORLD);
-		if (myrank != 0)
-			MPI_Recv(a[0], n, MPI_DOUBLE, myrank-1, 0, MPI_COMM_WORLD, &status);
-		// Step 2: Send upwards, recieve from below
-		if (myrank != 0)
-			MPI_Send(a[1], n, MPI_DOUBLE, myrank-1, 1, MPI_COMM_WORLD);
-		if (myrank != nprocs-1)
-			MPI_Recv(a[m-1], n, MPI_DOUBLE, myrank+1, 1, MPI_COMM_WORLD, &status);
-		
-		MPI_Allreduce(&diff, &gdiff, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
-	} while (gdiff > eps);
-	
-	Delete_Matrix(b);
+
+		done = false;
+		if (check) {
+			PHASE_BEGIN(tallred);
+			tstart = MPI_Wtime();
+			MPI_Allreduce(&diff, &gdiff, 1, MPI_DOUBLE, MPI_MAX, blk.comm);
+			treduce += MPI_Wtime() - tstart;
+			PHASE_END(tallred, PHASE_REDUCE);
+			done = ci.done(k, gdiff, eps);
+		}
+	} while (!done);
+
+	MPI_Type_free(&column);
+
+	double t[2] = { twait, treduce }, tmax[2];
+	MPI_Reduce(t, tmax, 2, MPI_DOUBLE, MPI_MAX, 0, blk.comm);
+	if (blk.rank == 0) {
+		cout << "Communication: halo wait " << tmax[0] << " s, reduction "
+			 << tmax[1] << " s\n";
+	}
 
 	return k;
 }
-
@@ -13,14 +13,27 @@
 
 #include <iostream>
 #include <iomanip>
-#include <fstream>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include <sys/time.h>
+#include <vector>
+#include <mpi.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
-using namespace std;
+#include "grid2d.h"
+#include "decomp.h"
+#include "matrixfile.h"
+#include "instrument.h"
 
+using namespace std;
 
+/*
+** Globale MPI variable
+*/
+int myrank, nprocs;
 /*
 ** The iterative computation terminates, if each element has changed
 ** by at most 'eps', as compared to the last iteration.
@@ -28,204 +41,380 @@ using namespace std;
 double eps = 0.001;
 
 /*
-** Execute the iterative solver on the n*n matrix 'a'.
+** Execute the iterative solver on the own block 'a' of the n*n matrix.
 */
-extern int solver(double **a, int n);
+extern int solver(Grid2D<double> &a, const Block &blk);
 	
 
 /* Auxiliary Functions ************************************************* */
 
 /*
-** Allocate a 2D array with m * n elements (m rows with n columns).
-** I.e., something like ``new double[m][n]'' ...
-*/
-double ** New_Matrix(int m, int n)
+** Auxiliary function: Print an element of a 2D array.
+void print(double **a, int x, int y)
 {
-	double **res;
-	double *array;
-	int i;
-
-	/*
-	** Result is a 1D array with pointers to the rows of the 2D array
-	*/
-	res = new double*[m];
-
-	/*
-    ** The actual array is allocated in one piece for efficiency reasons.
-	** This corresponds to the memory layout that it would have with static
-    ** allocation.
-	*/
-	array = new double[m*n];
-
-	/*
-	** Each row pointer is now initialized with the correct value.
-	** (Row i starts at element i*n)
-	*/
-	for (i = 0; i < m; i++) {
-		res[i] = &array[i * n];
-	}
-
-	return res;
+	cout << "  a[" << setw(4) << x << "][" << setw(4) << y << "] = "
+		 << setw(0) << setprecision(18) << a[x][y] << "\n";
 }
+*/
 
 /*
-** Deallocate a 2D array.
+** Returns the current time in seconds as a floating point value
 */
-void Delete_Matrix(double **matrix)
+double getTime()
 {
-	delete[] matrix[0];
-	delete[] matrix;
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec * 0.000001;
 }
 
+
+/* Distribution of the matrix ******************************************* */
+
 /*
-** Auxiliary function: Print an element of a 2D array.
+** Block of process p (in the Cartesian communicator of 'blk').
 */
-void print(double **a, int x, int y)
+Block Block_Of(const Block &blk, int p)
 {
-	cout << "  a[" << setw(4) << x << "][" << setw(4) << y << "] = "
-		 << setw(0) << setprecision(18) << a[x][y] << "\n";
+	Block b = blk;
+	b.rank = p;
+	MPI_Cart_coords(blk.comm, p, 2, b.coords);
+	b.row0 = blockStart(b.n, b.coords[0], b.dims[0]);
+	b.rows = blockSize(b.n, b.coords[0], b.dims[0]);
+	b.col0 = blockStart(b.n, b.coords[1], b.dims[1]);
+	b.cols = blockSize(b.n, b.coords[1], b.dims[1]);
+	return b;
 }
 
+
+/* Initialization ******************************************************* */
+
 /*
-** Returns the current time in seconds as a floating point value
+** Assign the initial values to the own block 'a' (including the halo),
+** computed from the global indices, so that no process needs the whole
+** matrix. With OpenMP, each thread initializes the rows which it later
+** computes (first touch):
+** The upper left and the lower right corner are cold (value 0),
+** the lower left and the upper right corner are hot (value 1),
+** between the corners, the temperature is changing linearly.
+** The interior is 0.
 */
-double getTime()
+void Init_Block(Grid2D<double> &a, const Block &blk)
 {
-	struct timeval tv;
-	gettimeofday(&tv, NULL);
-	return tv.tv_sec + tv.tv_usec * 0.000001;
+	int i, j, n = blk.n;
+
+	#pragma omp parallel for private(j)
+	for (i=-1; i<=blk.rows; i++) {
+		for (j=-1; j<=blk.cols; j++) {
+			int gi = blk.row0 + i, gj = blk.col0 + j;
+			double v = 0;
+			if ((gi < 0) || (gi >= n) || (gj < 0) || (gj >= n))
+				v = 0;                      /* Outside of the matrix */
+			else if (gj == 0)
+				v = (double)gi / (n-1);
+			else if (gj == n-1)
+				v = (double)(n-1-gi) / (n-1);
+			else if (gi == 0)
+				v = (double)gj / (n-1);
+			else if (gi == n-1)
+				v = (double)(n-1-gj) / (n-1);
+			a[i][j] = v;
+		}
+	}
 }
 
+
 /* File output ******************************************************** */
 
 /*
-** Write the n*n matrix 'a' into the file 'Matrix.txt'.
+** Write the n*n matrix, which is distributed in blocks 'a', into the
+** file 'Matrix.txt'. The matrix is collected row by row on process 0
+** (with MPI_Gatherv), so that it only needs memory for one row.
 */
-void Write_Matrix(double **a, int n)
+void Write_Matrix(Grid2D<double> &a, const Block &blk)
 {
-	int i, j;
-	/* Open file for writing */
-	fstream file("Matrix.txt", ios::out|ios::trunc);
-	
-	if (!file.is_open()) {
-		cerr << "Cannot open file 'Matrix.txt' for writing!";
-		exit(1);
-	}
+	int i, j, p, n = blk.n;
+	FILE *file = NULL;
+	vector<double> row;
+	vector<char> text;
+	vector<int> counts, displs;
+	vector<Block> blocks;
 
-	/* Write the size of the matrix */
-	file << n << "\n\n";
+	if (blk.rank == 0) {
+		/* Open file for writing */
+		file = fopen("Matrix.txt", "w");
+		if (file == NULL) {
+			cerr << "Cannot open file 'Matrix.txt' for writing!";
+			MPI_Abort(MPI_COMM_WORLD, 1);
+		}
+
+		/* Write the size of the matrix */
+		fprintf(file, "%d\n\n", n);
+
+		row.resize(n);
+		text.resize((size_t)n * MATRIX_NUMLEN + 1);
+		counts.resize(nprocs);
+		displs.resize(nprocs);
+		for (p=0; p<nprocs; p++)
+			blocks.push_back(Block_Of(blk, p));
+	}
 
 	/* Write the matrix elements into the file, row by row */
-	file << setprecision(10);
 	for (i = 0; i < n; i++) {
-		for (j = 0; j < n; j++) {
-			file << a[i][j] << "\n";
+		bool mine = (i >= blk.row0) && (i < blk.row0 + blk.rows);
+		if (blk.rank == 0) {
+			for (p=0; p<nprocs; p++) {
+				Block &b = blocks[p];
+				bool has = (i >= b.row0) && (i < b.row0 + b.rows);
+				counts[p] = has ? b.cols : 0;
+				displs[p] = b.col0;
+			}
+		}
+		MPI_Gatherv(mine ? a[i - blk.row0] : NULL, mine ? blk.cols : 0,
+					MPI_DOUBLE, row.data(), counts.data(), displs.data(),
+					MPI_DOUBLE, 0, blk.comm);
+		if (blk.rank == 0) {
+			/* Format the row (see matrixfile.h) and write it */
+			char *t = text.data();
+			for (j = 0; j < n; j++) {
+				t = formatElement(t, row[j]);
+			}
+			*t++ = '\n';
+			fwrite(text.data(), 1, t - text.data(), file);
 		}
-		file << "\n";
 	}
 
 	/* Close file */
-	file.close();
+	if ((blk.rank == 0) && (fclose(file) != 0)) {
+		cerr << "Error writing file 'Matrix.txt'!";
+		MPI_Abort(MPI_COMM_WORLD, 1);
+	}
 }
 
-/* *********************************************************************** */
-
-int
-main(int argc, char **argv)
+/*
+** Write the n*n matrix, which is distributed in blocks 'a', into the
+** binary file 'Matrix.bin' (see matrixfile.h) with MPI-IO: the file view
+** of each process only contains its own block, so all processes write
+** in parallel with one collective operation.
+*/
+void Write_Matrix_Binary(Grid2D<double> &a, const Block &blk)
 {
-	int i, j;
-	int n;
-	double **a;
-	double start, end;
+	MPI_File fh;
+	MPI_Datatype filetype, memtype;
+	MatrixFileHeader h = matrixHeader(blk.n, blk.n);
+	int sizes[2] = { blk.n, blk.n };
+	int subsizes[2] = { blk.rows, blk.cols };
+	int starts[2] = { blk.row0, blk.col0 };
 
-	if ((argc < 2) || (argc > 3)) {
-		cerr << "Usage: heat <size> [<epsilon>] !\n\n"
-			 << "   <size>      -- Size of matrix\n"
-			 << "   <epsilon>   -- accuracy parameter\n";
-		exit(1);
+	if (MPI_File_open(blk.comm, (char *)"Matrix.bin", MPI_MODE_CREATE|MPI_MODE_WRONLY,
+					  MPI_INFO_NULL, &fh) != MPI_SUCCESS) {
+		cerr << "Cannot open file 'Matrix.bin' for writing!";
+		MPI_Abort(MPI_COMM_WORLD, 1);
 	}
+	MPI_File_set_size(fh, sizeof(h) + (MPI_Offset)blk.n * blk.n * sizeof(double));
 
-	/*
-	** First argument: size of the matrix
-	*/
-	n = atoi(argv[1]);
-	if ((n < 3) || (n > 6000)) {
-		cerr << "Error: size out of range [3 .. 6000] !\n";
-		exit(1);
-	}
+	/* Header */
+	if (blk.rank == 0)
+		MPI_File_write_at(fh, 0, &h, sizeof(h), MPI_BYTE, MPI_STATUS_IGNORE);
 
 	/*
-	** Second (optional) argument: "accuracy parameter" eps
+	** Own block: 'filetype' selects it from the matrix in the file,
+	** 'memtype' from the grid in memory (without the halo)
 	*/
-	if (argc >= 3) {
-		eps = atof(argv[2]);
-	}
-	if (eps <= 0) {
-		cerr <<	"Error: epsilon must be > 0! "
-			 <<	"(try values between 0.01 and 0.0000000001)\n";
-		exit(1);
+	MPI_Type_create_subarray(2, sizes, subsizes, starts, MPI_ORDER_C,
+							 MPI_DOUBLE, &filetype);
+	MPI_Type_commit(&filetype);
+	MPI_Type_vector(blk.rows, blk.cols, a.stride(), MPI_DOUBLE, &memtype);
+	MPI_Type_commit(&memtype);
+
+	MPI_File_set_view(fh, sizeof(h), MPI_DOUBLE, filetype, (char *)"native",
+					  MPI_INFO_NULL);
+	MPI_File_write_all(fh, a[0], 1, memtype, MPI_STATUS_IGNORE);
+	MPI_File_close(&fh);
+
+	MPI_Type_free(&filetype);
+	MPI_Type_free(&memtype);
+}
+
+/*
+** Output of the matrix (environment variable MATRIX_OUTPUT):
+**   auto     Matrix.txt, if n <= 1000 (default)
+**   binary   Matrix.bin
+**   text     Matrix.txt (for ViewMatrix)
+**   none     no output
+** ViewMatrix reads only the text format.
+*/
+enum Output { NONE, TEXT, BINARY };
+
+Output Output_Format(int n)
+{
+	const char *env = getenv("MATRIX_OUTPUT");
+	if ((env == NULL) || (strcmp(env, "auto") == 0))
+		return (n <= 1000) ? TEXT : NONE;
+	if (strcmp(env, "none") == 0)
+		return NONE;
+	return (strcmp(env, "text") == 0) ? TEXT : BINARY;
+}
+
+/*
+** Print the element a[x][y] (global indices), if it is in the own block.
+*/
+void print(Grid2D<double> &a, const Block &blk, int x, int y)
+{
+	if (blk.owns(x, y)) {
+		cout << "  a[" << setw(4) << x << "][" << setw(4) << y << "] = "
+			 << setw(0) << setprecision(18) << a[x-blk.row0][y-blk.col0] << "\n";
 	}
+}
+/* *********************************************************************** */
+
+int main(int argc, char **argv)
+{
+	int i;
+	int n;
+	double start, end;
 
 	/*
-	** Allocate new matrix
+	** Initialize MPI and set arguments. With OpenMP (heat-hybrid), only
+	** the master thread calls MPI functions.
 	*/
-	a = New_Matrix(n, n);
-	if (a == NULL) {
-		cerr << "Can't allocate matrix !\n";
-		exit(1);
+#ifdef _OPENMP
+	int provided;
+	MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+	if (provided < MPI_THREAD_FUNNELED) {
+		cerr << "Error: MPI does not support MPI_THREAD_FUNNELED!\n";
+		MPI_Abort(MPI_COMM_WORLD, 1);
 	}
-		
-	/*
-	** Initialize the matrix
-	*/
-	for (i=0; i<n; i++) {
-		for (j=0; j<n; j++) {
-			a[i][j] = 0;
+#else
+	MPI_Init(&argc, &argv);
+#endif
+
+	/* Determine the number of processes */
+	MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+
+	/* Determine own rank */
+	MPI_Comm_rank(MPI_COMM_WORLD, &myrank);
+
+	if (myrank == 0) {
+		if ((argc < 2) || (argc > 3)) {
+			cerr << "Usage: heat <size> [<epsilon>] !\n\n"
+				<< "   <size>      -- Size of matrix\n"
+				<< "   <epsilon>   -- accuracy parameter\n";
+			MPI_Abort(MPI_COMM_WORLD, 0);
 		}
+
+		/*
+		** First argument: size of the matrix
+		*/
+		n = atoi(argv[1]);
+		if ((n < 3) || (n > 6000)) {
+			cerr << "Error: size out of range [3 .. 6000] !\n";
+			MPI_Abort(MPI_COMM_WORLD, 0);
+		}
+
+		/*
+		** Second (optional) argument: "accuracy parameter" eps
+		*/
+		if (argc >= 3) {
+			eps = atof(argv[2]);
+		}
+		if (eps <= 0) {
+			cerr <<	"Error: epsilon must be > 0! "
+				<<	"(try values between 0.01 and 0.0000000001)\n";
+			MPI_Abort(MPI_COMM_WORLD, 0);
+		}
+	}
+	MPI_Bcast(&n, 1, MPI_INT, 0, MPI_COMM_WORLD);
+	if (argc >= 3) {
+		MPI_Bcast(&eps, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
 	}
 
 	/*
-	** Assign the boundary values:
-	** The upper left and the lower right corner are cold (value 0),
-	** the lower left and the upper right corner are hot (value 1),
-	** between the corners, the temperature is changing linearly.
+	** Process grid and own block (see decomp.h), which consists of whole
+	** rows for the Gauss/Seidel pipeline. The block has a halo of one
+	** element for the neighbors' values. Each process initializes its
+	** own block.
 	*/
-	for (i=0; i<n; i++) {
-		double x = (double)i / (n-1);
-		a[i][0]       = x;
-		a[n-1-i][n-1] = x;
-		a[0][i]       = x;
-		a[n-1][n-1-i] = x;
+	Block blk = createBlock(n, true);
+	if (myrank == 0) {
+		cout << "Processes: " << blk.dims[0] << " x " << blk.dims[1];
+#ifdef _OPENMP
+		cout << ", " << omp_get_max_threads() << " threads each";
+#endif
+		cout << "\n";
 	}
+	Grid2D<double> b(blk.rows, blk.cols, 1);
+	if (b.data() == NULL) {
+		cerr << "Can't allocate matrix !\n";
+		MPI_Abort(MPI_COMM_WORLD, 0);
+	}
+	Init_Block(b, blk);
 
-	/*
-	** Call the iterative solver on matrix 'a'
-	*/
+#ifdef INSTRUMENT
+	PerfCounters counters;
+	counters.start();
+#endif
 	start = getTime();
-	int niter = solver(a, n);
+	int niter = solver(b, blk);
 	end = getTime();
+#ifdef INSTRUMENT
+	counters.stop();
+
+	/*
+	** Counters: sum over all processes (n/a, if not available in one of
+	** them), phases: maximum over all processes
+	*/
+	double csum[NCOUNTERS], cmin[NCOUNTERS], pmax[NPHASES];
+	MPI_Reduce(counters.value, csum, NCOUNTERS, MPI_DOUBLE, MPI_SUM, 0, blk.comm);
+	MPI_Reduce(counters.value, cmin, NCOUNTERS, MPI_DOUBLE, MPI_MIN, 0, blk.comm);
+	MPI_Reduce(phaseTime, pmax, NPHASES, MPI_DOUBLE, MPI_MAX, 0, blk.comm);
+	for (i=0; i<NCOUNTERS; i++) {
+		if (cmin[i] < 0)
+			csum[i] = -1;
+	}
+#endif
 
 	/*
 	** Write the matrix into a file
 	*/
-	if (n <= 1000) {
-		Write_Matrix(a, n);
+	Output out = Output_Format(n);
+	if (out != NONE) {
+		MPI_Barrier(blk.comm);
+		double t = getTime();
+		if (out == TEXT)
+			Write_Matrix(b, blk);
+		else
+			Write_Matrix_Binary(b, blk);
+		MPI_Barrier(blk.comm);
+		t = getTime() - t;
+		if (myrank == 0) {
+			double mb = 1e-6 * n * n * sizeof(double);
+			cout << fixed << setprecision(3) << "Output: "
+				 << ((out == TEXT) ? "Matrix.txt" : "Matrix.bin") << ", "
+				 << t << " s, " << (mb / t) << " MB/s (" << mb
+				 << " MB of data)\n" << defaultfloat;
+		}
 	}
 
 	/*
 	** Statistics and some verification values
 	*/
-	cout << "Result: " << niter << " iterations\n";
 	i = n/8;
-	print(a, n-1-i, i);
-	print(a, n-1-i, i/2);
-	print(a, n/2, n/2);
-	print(a, i/2, n-1-i);
-	print(a, i, n-1-i);
-
-	double time = (end-start);
-	cout << fixed << setprecision(3) << "Runtime: " << time << " s\n";
-	cout << "Performance: " << (1e-9*niter*(n-2)*(n-2)*4/time) << " GFlop/s\n";
+	print(b, blk, n-1-i, i);
+	print(b, blk, n-1-i, i/2);
+	print(b, blk, n/2, n/2);
+	print(b, blk, i/2, n-1-i);
+	print(b, blk, i, n-1-i);
+	if (myrank == 0) {
+		cout << "Result: " << niter << " iterations\n";
+		double time = (end-start);
+		cout << fixed << setprecision(3) << "Runtime: " << time << " s\n";
+		cout << "Performance: " << (1e-9*niter*(n-2)*(n-2)*4/time) << " GFlop/s\n";
+#ifdef INSTRUMENT
+		instrumentReport(csum, pmax, (double)niter*(n-2)*(n-2), time);
+#endif
+	}
+
+	MPI_Finalize();
+
 	return 0;
 }
-
@@ -0,0 +1,274 @@
+/*************************************************************************
+** Optional instrumentation of the solvers (compile with -DINSTRUMENT,
+** e.g., make OPT="-O2 -DINSTRUMENT")
+**
+** Hardware counters: heat opens the counters with perf_event_open()
+** before it calls the solver, starts them before the solver and stops
+** them afterwards:
+**   - cycles
+**   - LLC misses (all accesses)
+**   - LLC read misses: times 64 bytes, this is used as the number of
+**     bytes read from memory. Hardware prefetches are not included, so
+**     this is a lower bound.
+**   - vector instructions: packed double precision instructions
+**     (FP_ARITH_INST_RETIRED, Intel only). On other CPUs, a raw event
+**     can be given in the environment variable PERF_VECTOR_EVENT
+**     (e.g. PERF_VECTOR_EVENT=0x54c7).
+**   - CPU time (software counter, always available)
+** With OpenMP, each thread of the team opens its own counters, and the
+** values are added. The counters are only counted in user mode, which
+** is allowed with perf_event_paranoid <= 2. A counter which can not be
+** opened (e.g., in a virtual machine without a PMU) is reported as
+** "n/a".
+**
+** Phases: the solvers measure the time of their phases with
+** PHASE_BEGIN() / PHASE_END() (outside of parallel regions):
+**   sweep          update of the matrix elements
+**   copy           copies of the matrix (boundary, checkpoints)
+**   reduction      global maximum of the change (only if separate)
+**   communication  MPI messages (incl. waiting)
+** Solvers without these calls only report the counters.
+**
+** From the counters, heat computes the arithmetic intensity (4 Flop per
+** element update / bytes read from memory) and the bandwidth, i.e., the
+** position of the solver in the roofline model.
+**
+** Without INSTRUMENT, PHASE_BEGIN() and PHASE_END() are empty.
+**
+** Author:   RW
+**
+*************************************************************************/
+
+#ifndef INSTRUMENT_H
+#define INSTRUMENT_H
+
+enum Phase { PHASE_SWEEP, PHASE_COPY, PHASE_REDUCE, PHASE_COMM, NPHASES };
+
+#ifdef INSTRUMENT
+
+#include <iostream>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+enum Counter { CNT_CYCLES, CNT_LLC_MISSES, CNT_LLC_READ_MISSES, CNT_VECTOR,
+			   CNT_CPU_TIME, NCOUNTERS };
+
+#define CACHE_LINE 64
+
+/*
+** Accumulated time of the phases in seconds
+*/
+inline double phaseTime[NPHASES];
+
+inline double phaseClock()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+#define PHASE_BEGIN(t)   double t = phaseClock()
+#define PHASE_END(t, p)  (phaseTime[p] += phaseClock() - (t))
+
+class PerfCounters
+{
+public:
+	/*
+	** Open the counters for all threads of the OpenMP team. They are
+	** started with start().
+	*/
+	PerfCounters()
+	{
+		nthreads = 1;
+#ifdef _OPENMP
+		nthreads = omp_get_max_threads();
+#endif
+		fds = new int[nthreads * NCOUNTERS];
+		for (int i = 0; i < nthreads * NCOUNTERS; i++)
+			fds[i] = -1;
+		for (int c = 0; c < NCOUNTERS; c++)
+			value[c] = -1;
+
+		#pragma omp parallel
+		{
+			int t = 0;
+#ifdef _OPENMP
+			t = omp_get_thread_num();
+#endif
+			for (int c = 0; c < NCOUNTERS; c++)
+				fds[t * NCOUNTERS + c] = openCounter(c);
+		}
+	}
+
+	~PerfCounters()
+	{
+		for (int i = 0; i < nthreads * NCOUNTERS; i++) {
+			if (fds[i] >= 0)
+				close(fds[i]);
+		}
+		delete[] fds;
+	}
+
+	void start()
+	{
+		for (int i = 0; i < nthreads * NCOUNTERS; i++) {
+			if (fds[i] >= 0) {
+				ioctl(fds[i], PERF_EVENT_IOC_RESET, 0);
+				ioctl(fds[i], PERF_EVENT_IOC_ENABLE, 0);
+			}
+		}
+	}
+
+	/*
+	** Stop the counters and add up the values of the threads in 'value'.
+	** If a counter was multiplexed with others, its value is scaled up
+	** to the whole time. The CPU time is in seconds.
+	*/
+	void stop()
+	{
+		for (int i = 0; i < nthreads * NCOUNTERS; i++) {
+			if (fds[i] >= 0)
+				ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+		}
+		for (int c = 0; c < NCOUNTERS; c++) {
+			value[c] = -1;
+			for (int t = 0; t < nthreads; t++) {
+				uint64_t v[3];   /* Value, time enabled, time running */
+				int fd = fds[t * NCOUNTERS + c];
+				if ((fd < 0) || (read(fd, v, sizeof(v)) != sizeof(v)))
+					continue;
+				double x = (v[2] > 0) ? (double)v[0] * v[1] / v[2] : 0;
+				value[c] = ((value[c] < 0) ? 0 : value[c]) + x;
+			}
+		}
+		if (value[CNT_CPU_TIME] > 0)
+			value[CNT_CPU_TIME] *= 1e-9;
+	}
+
+	double value[NCOUNTERS];   /* Values, or -1, if not available */
+
+private:
+	static int openCounter(int c)
+	{
+		struct perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.disabled = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED |
+						   PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+		switch (c) {
+		case CNT_CYCLES:
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = PERF_COUNT_HW_CPU_CYCLES;
+			break;
+		case CNT_LLC_MISSES:
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = PERF_COUNT_HW_CACHE_MISSES;
+			break;
+		case CNT_LLC_READ_MISSES:
+			attr.type = PERF_TYPE_HW_CACHE;
+			attr.config = PERF_COUNT_HW_CACHE_LL |
+						  (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+						  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+			break;
+		case CNT_VECTOR: {
+			/*
+			** FP_ARITH_INST_RETIRED (event 0xc7), umask: 128, 256 and
+			** 512 bit packed double (0x04 | 0x10 | 0x40)
+			*/
+			const char *env = getenv("PERF_VECTOR_EVENT");
+			attr.type = PERF_TYPE_RAW;
+			if (env != NULL)
+				attr.config = strtoull(env, NULL, 0);
+			else if (__builtin_cpu_is("intel"))
+				attr.config = 0x54c7;
+			else
+				return -1;
+			break;
+		}
+		case CNT_CPU_TIME:
+			attr.type = PERF_TYPE_SOFTWARE;
+			attr.config = PERF_COUNT_SW_TASK_CLOCK;
+			break;
+		}
+		return syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+	}
+
+	int nthreads;
+	int *fds;       /* fds[t * NCOUNTERS + c]: counter c of thread t */
+};
+
+/*
+** Print the counters 'value' (see PerfCounters), the times of the phases
+** and the roofline values for 'updates' element updates in 'time'
+** seconds.
+*/
+inline void instrumentReport(const double *value, const double *phase,
+							 double updates, double time)
+{
+	static const char *cname[NCOUNTERS] = {
+		"cycles", "LLC misses", "LLC read misses", "vector instructions",
+		"CPU time"
+	};
+	static const char *pname[NPHASES] = {
+		"sweep", "copy", "reduction", "communication"
+	};
+	char buf[128];
+	int c, p;
+
+	std::cout << "Counters:";
+	for (c = 0; c < NCOUNTERS; c++) {
+		if (value[c] < 0)
+			snprintf(buf, sizeof(buf), " %s n/a", cname[c]);
+		else if (c == CNT_CPU_TIME)
+			snprintf(buf, sizeof(buf), " %s %.3f s", cname[c], value[c]);
+		else
+			snprintf(buf, sizeof(buf), " %s %.4g (%.3g per update)",
+					 cname[c], value[c], value[c] / updates);
+		std::cout << buf << ((c < NCOUNTERS - 1) ? "," : "\n");
+	}
+
+	bool any = false;
+	std::cout << "Phases:";
+	for (p = 0; p < NPHASES; p++) {
+		if (phase[p] > 0) {
+			snprintf(buf, sizeof(buf), "%s %s %.3f s", any ? "," : "",
+					 pname[p], phase[p]);
+			std::cout << buf;
+			any = true;
+		}
+	}
+	std::cout << (any ? "\n" : " not measured by this solver\n");
+
+	if (value[CNT_LLC_READ_MISSES] < 0) {
+		std::cout << "Roofline: n/a (no LLC read misses)\n";
+		return;
+	}
+	double bytes = value[CNT_LLC_READ_MISSES] * CACHE_LINE;
+	snprintf(buf, sizeof(buf), "Roofline: %.3g Flop/Byte, %.3f GB/s read "
+			 "from memory, %.3f GFlop/s\n", (bytes > 0) ? 4 * updates / bytes : 0,
+			 1e-9 * bytes / time, 1e-9 * 4 * updates / time);
+	std::cout << buf;
+}
+
+#else
+
+#define PHASE_BEGIN(t)
+#define PHASE_END(t, p)
+
+#endif
+
+#endif
@@ -1,12 +1,49 @@
 /*************************************************************************
 ** Iterative solver: Gauss/Seidel method
 **
+** Each process owns a block of whole rows of the matrix (see decomp.h),
+** with a ghost row above and below. In Gauss/Seidel, a[i][j] uses the
+** new values of the left and upper neighbors and the old values of the
+** right and lower neighbors. So process r can only start iteration k
+** with the new last row of process r-1 (iteration k) and the first row
+** of process r+1 from iteration k-1.
+**
+** To let the processes work in parallel (as a pipeline), the columns are
+** split into chunks. The chunks are updated one after the other, each
+** one for all rows of the block. This gives exactly the same results as
+** the row by row order, since all dependencies are still met. After a
+** chunk, its part of the last row is sent to the process below, which
+** can then start this chunk, and its part of the first row is sent to
+** the process above, which needs it in the next iteration. So process r
+** starts r chunks after process 0, and the iterations overlap.
+**
+** Small chunks make the pipeline fill faster, large chunks need fewer
+** messages. The rows are sent directly from the matrix with non-blocking
+** sends, which must complete before the chunk is updated again.
+**
+** The number of iterations is fixed (as before), so the results are
+** bit-identical to the sequential version for any number of processes.
+** The time spent waiting for the neighbors is reported (maximum over all
+** processes).
+**
+** Environment variable:
+**   GS_CHUNK  number of columns per chunk (default 256)
+**
 ** Author:   RW
-** 
+**
 *************************************************************************/
 
+#include <iostream>
 #include <stdlib.h>
 #include <math.h>
+#include <vector>
+#include <mpi.h>
+
+#include "grid2d.h"
+#include "decomp.h"
+#include "instrument.h"
+
+using namespace std;
 
 /*
 ** The iterative computation terminates, if the accuracy is at least 'eps'.
@@ -14,18 +51,13 @@
 extern double eps;
 
 
-/* Auxiliary Functions *************************************************** */
-
-extern double ** New_Matrix(int m, int n);
-extern void Delete_Matrix(double **matrix);
-
-
 /* Gauss/Seidel relaxation *********************************************** */
 
 /*
-** Execute Gau/Seidel relaxation on the n*n matrix 'a'.
+** Execute Gau/Seidel relaxation on the block 'a' (with a halo of 1) of
+** the n*n matrix.
 */
-int solver(double **a, int n)
+int solver(Grid2D<double> &a, const Block &blk)
 {
 	/*
 	** Simple estimation for the number of iterations, which is needed to
@@ -34,18 +66,92 @@ int solver(double **a, int n)
 	int kmax = (int)(0.35 / eps);
 	int i,j;
 	int k;          /* Counts iterations */
+	int c;
+	int n = blk.n, rows = blk.rows;
+	double tstart, twait = 0;
+
+	const char *env = getenv("GS_CHUNK");
+	int chunk = (env != NULL) ? atoi(env) : 256;
+	if (chunk < 1)
+		chunk = 1;
+	int nchunks = (n - 2 + chunk - 1) / chunk;
+
+	/*
+	** Rows to be updated (the global boundary is fixed)
+	*/
+	int ilo = (blk.row0 == 0) ? 1 : 0;
+	int ihi = (blk.row0 + rows == n) ? rows - 1 : rows;
+
+	/* Pending sends of the first/last row, per chunk */
+	vector<MPI_Request> sendUp(nchunks, MPI_REQUEST_NULL);
+	vector<MPI_Request> sendDown(nchunks, MPI_REQUEST_NULL);
 
 	/*
 	** Iterate 'k' times.
 	*/
 	for (k=0; k<kmax; k++) {
-		for (i=1; i<n-1; i++) {
-			for (j=1; j<n-1; j++) {
-				a[i][j] = 0.25 * (a[i][j-1] + a[i-1][j] +
-								  a[i+1][j] + a[i][j+1]);
+		for (c=0; c<nchunks; c++) {
+			int j0 = 1 + c * chunk;
+			int j1 = (j0 + chunk < n - 1) ? j0 + chunk : n - 1;
+			int len = j1 - j0;
+
+			/*
+			** New values above (iteration k) and, from iteration 1 on, the
+			** values below from the last iteration. In iteration 0, the
+			** ghost row below still holds the initial values. Before the
+			** rows are changed, the last sends of this chunk must be
+			** complete.
+			*/
+			PHASE_BEGIN(tcomm);
+			tstart = MPI_Wtime();
+			MPI_Recv(&a[-1][j0], len, MPI_DOUBLE, blk.up, 0, blk.comm,
+					 MPI_STATUS_IGNORE);
+			if (k > 0) {
+				MPI_Recv(&a[rows][j0], len, MPI_DOUBLE, blk.down, 1, blk.comm,
+						 MPI_STATUS_IGNORE);
 			}
+			MPI_Wait(&sendUp[c], MPI_STATUS_IGNORE);
+			MPI_Wait(&sendDown[c], MPI_STATUS_IGNORE);
+			twait += MPI_Wtime() - tstart;
+			PHASE_END(tcomm, PHASE_COMM);
+
+			PHASE_BEGIN(tsweep);
+			for (i=ilo; i<ihi; i++) {
+				for (j=j0; j<j1; j++) {
+					a[i][j] = 0.25 * (a[i][j-1] + a[i-1][j] +
+									  a[i+1][j] + a[i][j+1]);
+				}
+			}
+			PHASE_END(tsweep, PHASE_SWEEP);
+
+			/*
+			** The process below needs the last row in this iteration, the
+			** process above needs the first row in the next one.
+			*/
+			PHASE_BEGIN(tsend);
+			MPI_Isend(&a[rows-1][j0], len, MPI_DOUBLE, blk.down, 0, blk.comm,
+					  &sendDown[c]);
+			if (k < kmax - 1) {
+				MPI_Isend(&a[0][j0], len, MPI_DOUBLE, blk.up, 1, blk.comm,
+						  &sendUp[c]);
+			}
+			PHASE_END(tsend, PHASE_COMM);
 		}
 	}
+
+	PHASE_BEGIN(tcomm);
+	tstart = MPI_Wtime();
+	MPI_Waitall(nchunks, sendUp.data(), MPI_STATUSES_IGNORE);
+	MPI_Waitall(nchunks, sendDown.data(), MPI_STATUSES_IGNORE);
+	twait += MPI_Wtime() - tstart;
+	PHASE_END(tcomm, PHASE_COMM);
+
+	double tmax;
+	MPI_Reduce(&twait, &tmax, 1, MPI_DOUBLE, MPI_MAX, 0, blk.comm);
+	if (blk.rank == 0) {
+		cout << "Communication: pipeline wait " << tmax << " s ("
+			 << nchunks << " chunks of " << chunk << " columns)\n";
+	}
+
 	return kmax;
 }
-
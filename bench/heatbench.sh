@@ -0,0 +1,293 @@
+#!/bin/sh
+#########################################################################
+# Benchmark and validation of the heat solvers
+#
+# Builds and runs all variants of the heat program (Lab 2 and Lab 4) for
+# all combinations of matrix sizes, epsilons and thread/process counts,
+# compares the five sample points with stored reference values and
+# writes one CSV line per run:
+#
+#   variant,n,eps,ranks,threads,iterations,runtime_s,gflops,gbytes_s,
+#   max_rel_err,status
+#
+# 'gflops' is taken from the program ("Performance:"). 'gbytes_s' is the
+# memory bandwidth from a simple model: the bytes per element update of
+# the variant (see below), assuming the matrix does not fit in the cache.
+# It is empty for CG and multigrid, where an iteration is not a sweep.
+#
+# Variants with the same algorithm share the references of their
+# family, e.g., all Jacobi variants must give the results of the
+# sequential Jacobi solver. 'status' is PASS, if all sample points are
+# within the relative tolerance, FAIL if not, NOREF if there is no
+# reference value, or ERROR if the program failed.
+#
+# Usage: heatbench.sh [-u] [-b] [-o <file>] [<variant> ...]
+#   -u   compute the reference values (with the reference variant of
+#        each family and one thread) and store them in reference.txt
+#   -b   rebuild all programs (e.g., after changing OPT)
+#   -o   write the CSV into <file> instead of stdout
+#   <variant>  only run these variants (default: all, see below)
+#
+# Environment variables (defaults in brackets):
+#   SIZES     matrix sizes ["100 300"]
+#   EPSILONS  accuracy parameters ["0.001 0.0001"]
+#   THREADS   OpenMP thread counts ["1 2 4"]
+#   RANKS     MPI process counts ["1 2 4"]
+#   TOL       relative tolerance of the sample points [1e-6]
+#   OPT       compiler options for make ["-O2"]
+#   MPIRUN    command to start MPI programs ["mpirun"]
+#
+# The programs are run with MATRIX_OUTPUT=none. Other settings (e.g.,
+# STENCIL_ISA, CHECK_INTERVAL, DECOMP, GS_CHUNK) are passed through.
+#
+# Author:   RW
+#
+#########################################################################
+
+root=`cd "\`dirname "$0"\`/.." && pwd`
+refs="$root/bench/reference.txt"
+
+SIZES=${SIZES:-"100 300"}
+EPSILONS=${EPSILONS:-"0.001 0.0001"}
+THREADS=${THREADS:-"1 2 4"}
+RANKS=${RANKS:-"1 2 4"}
+TOL=${TOL:-1e-6}
+OPT=${OPT:-"-O2"}
+MPIRUN=${MPIRUN:-"mpirun"}
+
+#
+# The variants: name|directory|program [options]|kind|family|bytes per update
+#   kind: serial (one thread), omp (THREADS), mpi (RANKS),
+#         hybrid (RANKS x THREADS)
+# The variants all-* are the solvers of heat-all (Lab 2/Exercise3), which
+# contains all solvers of Lab 2 in one program.
+# The first variant of each family with kind 'serial', or else the first
+# one, computes the reference values.
+#
+variants() {
+	cat <<EOF
+jacobi-serial|Lab 2/Exercise3|heat-initial|serial|jacobi|24
+jacobi-omp|Lab 2/Exercise3|heat|omp|jacobi|24
+jacobi-tiled|Lab 2/Exercise3|heat-tiled|omp|jacobi|24
+multigrid|Lab 2/Exercise3|heat-multigrid|omp|multigrid|
+cg|Lab 2/Exercise3|heat-cg|omp|cg|
+gs-serial|Lab 2/Exercise4|initial-heat|serial|gs|16
+gs-wavefront|Lab 2/Exercise4|heat|omp|gs|16
+gs-redblack|Lab 2/Exercise4|heat-redblack|omp|redblack|32
+sor|Lab 2/Exercise4|heat-sor|omp|sor|16
+sor-redblack|Lab 2/Exercise4|heat-redblack-sor|omp|sor-redblack|32
+gs-cond|Lab 2/Exercise5|heat|omp|gs|16
+jacobi-mpi|Lab 4/Exercise2|heat|mpi|jacobi|24
+jacobi-hybrid|Lab 4/Exercise2|heat-hybrid|hybrid|jacobi|24
+gs-mpi|Lab 4/Exercise3|heat|mpi|gs|16
+all-jacobi|Lab 2/Exercise3|heat-all --solver=jacobi|omp|jacobi|24
+all-jacobi-tiled|Lab 2/Exercise3|heat-all --solver=jacobi-tiled|omp|jacobi|24
+all-gs-wavefront|Lab 2/Exercise3|heat-all --solver=gs-wavefront|omp|gs|16
+all-gs-redblack|Lab 2/Exercise3|heat-all --solver=gs-redblack|omp|redblack|32
+all-gs-cond|Lab 2/Exercise3|heat-all --solver=gs-cond|omp|gs|16
+all-sor|Lab 2/Exercise3|heat-all --solver=sor|omp|sor|16
+all-sor-redblack|Lab 2/Exercise3|heat-all --solver=sor-redblack|omp|sor-redblack|32
+all-cg|Lab 2/Exercise3|heat-all --solver=cg|omp|cg|
+all-multigrid|Lab 2/Exercise3|heat-all --solver=multigrid|omp|multigrid|
+EOF
+}
+
+update=0
+build=0
+out=
+while getopts "ubo:" opt
+do
+	case $opt in
+	u) update=1;;
+	b) build=1;;
+	o) out=$OPTARG;;
+	*) echo "Usage: heatbench.sh [-u] [-b] [-o <file>] [<variant> ...]" >&2
+	   exit 2;;
+	esac
+done
+shift `expr $OPTIND - 1`
+only="$*"
+
+#
+# Reference variant of a family
+#
+refvariant() {
+	variants | awk -F'|' -v f="$1" '
+		$5 == f { if (first == "") first = $1
+		          if (($4 == "serial") && (ser == "")) ser = $1 }
+		END { print (ser != "") ? ser : first }'
+}
+
+selected() {
+	[ -z "$only" ] && return 0
+	for v in $only
+	do
+		[ "$v" = "$1" ] && return 0
+	done
+	return 1
+}
+
+#
+# Build the programs of the selected variants once. Each program has its own
+# make target of the same name.
+#
+built=
+variants | while IFS='|' read name dir prog kind family bytes
+do
+	selected "$name" || continue
+	target=${prog%% *}
+	case "$built" in *"|$dir/$target|"*) continue;; esac
+	built="$built|$dir/$target|"
+	flags=
+	[ "$build" = 1 ] && flags=-B
+	if ! make -s -C "$root/$dir" $flags OPT="$OPT" $target >&2
+	then
+		echo "heatbench: build in '$dir' failed" >&2
+		exit 1
+	fi
+done || exit 1
+
+tmp=`mktemp -d`
+trap 'rm -rf "$tmp"' EXIT
+
+#
+# Run one variant: run <dir> <prog [options]> <kind> <ranks> <threads> <n>
+# <eps>. The output is in $tmp/out.
+#
+run() {
+	cd "$root/$1"
+	if [ "$3" = mpi ] || [ "$3" = hybrid ]
+	then
+		OMP_NUM_THREADS=$5 MATRIX_OUTPUT=none \
+			$MPIRUN -np $4 ./$2 $6 $7 > "$tmp/out" 2>&1 < /dev/null
+	else
+		OMP_NUM_THREADS=$5 MATRIX_OUTPUT=none \
+			./$2 $6 $7 > "$tmp/out" 2>&1 < /dev/null
+	fi
+	status=$?
+	cd "$root"
+	return $status
+}
+
+#
+# Sample points of the output: lines "<x> <y> <value>"
+#
+samples() {
+	sed -n 's/^ *a\[ *\([0-9]*\)\] *\[ *\([0-9]*\)\] = *\(.*\)$/\1 \2 \3/p' "$tmp/out"
+}
+
+#
+# Compute the reference values: one line "<family> <n> <eps> <x> <y>
+# <value>" per sample point. Existing values for other families, sizes
+# or epsilons are kept.
+#
+if [ "$update" = 1 ]
+then
+	touch "$refs"
+	cp "$refs" "$tmp/refs"
+	variants | while IFS='|' read name dir prog kind family bytes
+	do
+		[ "$name" = "`refvariant $family`" ] || continue
+		selected "$name" || continue
+		for n in $SIZES
+		do
+			for eps in $EPSILONS
+			do
+				if ! run "$dir" "$prog" "$kind" 1 1 $n $eps
+				then
+					echo "heatbench: $name $n $eps failed" >&2
+					cat "$tmp/out" >&2
+					exit 1
+				fi
+				grep -v "^$family $n $eps " "$tmp/refs" > "$tmp/refs.new"
+				samples | sed "s/^/$family $n $eps /" >> "$tmp/refs.new"
+				mv "$tmp/refs.new" "$tmp/refs"
+				echo "heatbench: reference $family n=$n eps=$eps ($name)" >&2
+			done
+		done
+	done || exit 1
+	sort -k1,1 -k2,2n -k3,3g -k4,4n -k5,5n "$tmp/refs" > "$refs"
+	exit 0
+fi
+
+#
+# Benchmark
+#
+[ -n "$out" ] && exec > "$out"
+[ -f "$refs" ] || refs=/dev/null
+echo "variant,n,eps,ranks,threads,iterations,runtime_s,gflops,gbytes_s,max_rel_err,status"
+variants | while IFS='|' read name dir prog kind family bytes
+do
+	selected "$name" || continue
+	case $kind in
+	serial) ranks=1; threads=1;;
+	omp)    ranks=1; threads=$THREADS;;
+	mpi)    ranks=$RANKS; threads=1;;
+	hybrid) ranks=$RANKS; threads=$THREADS;;
+	esac
+	for n in $SIZES
+	do
+		for eps in $EPSILONS
+		do
+			for p in $ranks
+			do
+				for t in $threads
+				do
+					if run "$dir" "$prog" "$kind" $p $t $n $eps
+					then
+						samples | awk -v fam=$family -v n=$n -v eps=$eps \
+							-v tol=$TOL -v out="$tmp/out" -v bytes="$bytes" \
+							-v prefix="$name,$n,$eps,$p,$t" -v reffile="$refs" '
+						# Reference values of this family, n and eps
+						FILENAME == reffile {
+							if (($1 == fam) && ($2 == n) && ($3 == eps))
+								ref[$4 " " $5] = $6
+							next
+						}
+						{
+							key = $1 " " $2
+							cnt++
+							if (!(key in ref)) {
+								noref = 1
+								next
+							}
+							d = $3 - ref[key]
+							if (d < 0) d = -d
+							r = ref[key]
+							if (r < 0) r = -r
+							err = (r > 0) ? d / r : d
+							if (err > maxerr) maxerr = err
+						}
+						END {
+							while ((getline line < out) > 0) {
+								split(line, f, " ")
+								if (f[1] == "Result:") iter = f[2]
+								if (f[1] == "Runtime:") time = f[2]
+								if (f[1] == "Performance:") gf = f[2]
+							}
+							gb = (bytes != "") ? sprintf("%.3f", gf * bytes / 4) : ""
+							if (cnt != 5) status = "ERROR"
+							else if (maxerr > tol) status = "FAIL"
+							else if (noref) status = "NOREF"
+							else status = "PASS"
+							printf "%s,%s,%s,%s,%s,%.3g,%s\n", prefix, iter, time, \
+								gf, gb, maxerr + 0, status
+						}' "$refs" -
+					else
+						echo "$name,$n,$eps,$p,$t,,,,,,ERROR"
+						echo "heatbench: $name $n $eps ($p x $t) failed:" >&2
+						cat "$tmp/out" >&2
+					fi
+				done
+			done
+		done
+	done
+done | tee "$tmp/csv"
+
+# Exit status 1, if a run failed or gave wrong results
+if grep -q ",\(FAIL\|ERROR\)\$" "$tmp/csv"
+then
+	echo "heatbench: !!! FAILED !!!" >&2
+	exit 1
+fi
+exit 0